@@ -1,5 +1,10 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
 
 /***********************************************************
 
@@ -18,6 +23,9 @@
 #define maxbio 50
 #define maxparm 100
 #define maxpsec 25 * maxparm
+#define nstage 4
+#define nbucket 24
+#define dumpmax 6 * 12 * ( maxparm + 1 ) + 64
 
 /**********************************************************
 
@@ -49,7 +57,7 @@ FILE *fp,*fpout;
 
 **************************************************************/
 
-char cc[2];
+char cc[3];
 int icruise=0, ostation=0, year=0, month=0, day=0;
 int hour,longitude,latitude;
 int levels,isoor,nparm,ip2[maxparm],iperror[maxparm];
@@ -136,6 +144,8 @@ int biocode[maxbio],bioval[maxbio];
 
  NTSETS - NUMBER OF TAXA SETS AT CAST
  NTLOC - NUMBER OF DELIMITORS FOR EACH TAXA SET
+ NTSTART - FIRST ENTRY OF EACH TAXA SET IN THE ARRAYS BELOW (THE
+           ENTRIES OF ALL SETS ARE PACKED END TO END)
  NTCODE - TAXA CODE FOR EACH TAXA VARIABLE
  NTVAL  - VALUE FOR EACH TAXA CODE
  NTERR - ERROR FLAG FOR EACH TAXA VALUE
@@ -148,6 +158,7 @@ int biocode[maxbio],bioval[maxbio];
 
 int ntsets;
 int *ntloc,*ntcode,*ntval,*nterr,*ntoerr,*nttotfig,*ntsigfig,*ntrightfig;
+int *ntstart;
 
 /*************************************************************
 
@@ -185,7 +196,9 @@ int *dataval,*derr,*doerr,*dtotfig,*dsigfig,*drightfig;
 
  ISIZE - PRESENT ARRAY SIZE NEEDED TO FIT ALL MEASURED VARIABLES
  ZSIZE - PRESENT ARRAY SIZE NEEDED TO FIT ALL DEPTHS
- NTSETSMAX - MAXIMUM NUMBER OF TAXA SETS
+ NTSETSMAX - SPACE ALLOCATED FOR TAXA SETS
+ NTENTMAX - SPACE ALLOCATED FOR TAXA SET ENTRIES (ALL SETS)
+ TAXBLOCK - SINGLE ALLOCATION HOLDING ALL TAXA ARRAYS
  ISIZEMAX - MAXIMUM ARRAY SIZE YET ENCOUNTERED FOR MEASURED VARIABLES
  ZSIZEMAX - MAXIMUM ARRAY SIZE YET ENCOUNTERED FOR DEPTHS
 
@@ -193,8 +206,66 @@ int *dataval,*derr,*doerr,*dtotfig,*dsigfig,*drightfig;
 
 int isize,zsize;
 int ntsetsmax=0, isizemax=0,zsizemax=0;
+int ntentmax=0;
+int *taxblock=NULL;
 int iVERSflag;
 
+/*************************************************************
+
+ RUN STATISTICS (PROGRAM RUN WITH -S)
+
+ STATMODE - SET TO ONE TO TIME EACH STAGE OF THE READ AND COUNT
+            WHAT WAS READ AND WRITTEN
+ RUNSTAT - TOTALS FOR THE RUN.  TINPUT IS TIME SPENT READING THE
+           WOD FILE, WHICH IS NOT COUNTED IN THEADER OR TLEVEL.
+ HIST - NUMBER OF CASTS TAKING LESS THAN 1, 2, 4, ... 2**(NBUCKET-1)
+        MICROSECONDS IN EACH STAGE (HEADER DECODE, LEVEL DECODE,
+        FORMAT, WRITE); THE LAST BUCKET HOLDS EVERYTHING SLOWER
+ FPCAST - IN-MEMORY STREAM RECEIVING THE PRINTOUT OF ONE CAST
+ FPFILE - OUTPUT FILE, WHEN FPOUT IS FPCAST
+
+*************************************************************/
+
+struct runstat {
+ long ncast;                 /* CASTS READ */
+ long nlevel, nvalue;        /* LEVELS AND DATA VALUES DECODED */
+ long nmissing;              /* DATA VALUES MISSING */
+ long nread, nwrite;         /* BYTES READ AND WRITTEN */
+ double tinput, theader, tlevel, tformat, twrite;
+ long hist[nstage][nbucket];
+};
+
+int statmode=0, statfd=-1;
+struct runstat runstats;
+FILE *fpcast=NULL, *fpfile=NULL;
+char *castbuf=NULL;
+size_t castlen=0;
+
+/*************************************************************
+
+ DUMP MODE (PROGRAM RUN WITH -D)
+
+ DUMPMODE - SET TO ONE TO WRITE EACH CAST AS COMMA DELIMITED
+            RECORDS (SEE DUMPCAST) INSTEAD OF THE PRINTOUT
+ DUMPLINE - RECORD BEING BUILT
+ DUMPP - NEXT FREE CHARACTER IN DUMPLINE
+
+*************************************************************/
+
+int dumpmode=0;
+char dumpline[dumpmax];
+char *dumpp=dumpline;
+
+/*************************************************************
+
+ FUNCTION PROTOTYPES (FOR FUNCTIONS NOT RETURNING INT)
+
+*************************************************************/
+
+double seconds();
+ssize_t statread(void *, char *, size_t);
+int statclose(void *);
+
 /*************************************************************
 
  INTERNAL ARRAYS
@@ -215,18 +286,39 @@ MODIFIED SEP. 25, 2008 AS PER EMAIL FROM TERRY DEVEAU
            2500., 3000., 3500., 4000., 4500., 5000., 5500., 6000.,
            6500., 7000., 7500., 8000., 8500., 9000. };
 
-main()
+main(int argc, char **argv)
 
 {
 
  char filename[80];
  int i=0, j, k, s, iend=0;
  int ncast=0;
+ double tstart, t0=0., t1;
+ static cookie_io_functions_t io = { statread, NULL, NULL, statclose };
+
+/********************************************************
+
+ RUN AS "WODC -S" TO REPORT TIMINGS AND COUNTS AT THE END,
+ AS "WODC -D" TO WRITE DELIMITED RECORDS INSTEAD OF THE PRINTOUT
+
+*********************************************************/
+
+ for ( k = 1; k < argc; k++ ) {
+  if ( strcmp(argv[k],"-s") == 0 ) statmode= 1;
+  else if ( strcmp(argv[k],"-d") == 0 ) dumpmode= 1;
+ }
+ tstart= seconds();
 
  printf(" Enter input file name\n");
  scanf("%s",filename);
 
- if ((fp = fopen(filename,"rb+\0")) == NULL)
+ if ( statmode == 1 ) {
+  if ( (statfd = open(filename,O_RDONLY)) == -1 ) fp= NULL;
+  else if ( (fp = fopencookie(&statfd,"rb",io)) == NULL ) close(statfd);
+ }
+ else fp = fopen(filename,"rb+\0");
+
+ if ( fp == NULL )
   printf("UNABLE TO OPEN FILE\n");
 
  else {
@@ -248,6 +340,15 @@ main()
    printf("UNABLE TO OPEN FILE\n");
   }
 
+  if ( statmode == 1 && fpout != NULL ) {
+   if ( (fpcast = open_memstream(&castbuf,&castlen)) == NULL ) {
+    printf(" NOT ENOUGH SPACE IN MEMORY FOR CAST OUTPUT\n");
+    return 1;
+   }
+   fpfile= fpout;
+   fpout= fpcast;
+  }
+
   printf(" ENTER NUMBER OF CASTS TO VIEW");
   printf (" (0 FOR ALL CASTS IN FILE)\n");
   if ( (s = scanf("%d",&ncast)) == 0 ) ncast=0;
@@ -276,12 +377,37 @@ main()
     if (  iVERSflag != 2 )
      for ( j = 0; j < 40; j++ ) *(depth+j)= *(sdepth+j);
 
-    printstation(i);
+    if ( statmode == 1 ) t0= seconds();
+    if ( dumpmode == 1 ) dumpcast();
+    else printstation(i);
+
+/********************************************************
+
+ WRITE OUT PRINTOUT OF THIS CAST, TIMED APART FROM FORMATTING
+
+********************************************************/
+
+    if ( fpfile != NULL ) {
+     t1= seconds();
+     fflush(fpcast);
+     castlen= ftell(fpcast);
+     fseek(fpcast,0L,SEEK_SET);
+     fwrite(castbuf,1,castlen,fpfile);
+     runstats.nwrite += castlen;
+     statadd(2,t1-t0);
+     statadd(3,seconds()-t1);
+     runstats.ncast++;
+    }
  
    }
 
   }
 
+  if ( fpfile != NULL ) {
+   fclose(fpfile);
+   statreport(seconds() - tstart);
+  }
+
  }
 
 }
@@ -298,6 +424,7 @@ oclread()
  int missing=-9999;
  int npinfs=0,npinfe=0,npinf;
  int iend=0;
+ double t0=0., tin=0., t;
 
 /**********************************************************
 
@@ -307,6 +434,11 @@ oclread()
 
 ***********************************************************/
 
+ if ( statmode == 1 ) {
+  t0= seconds();
+  tin= runstats.tinput;
+ }
+
  totfig= 1;
  if ( (iend = extractc(0,&totfig,&wodform)) == -1 ) return iend;
 
@@ -650,17 +782,13 @@ oclread()
 
 /***************************************************************
 
- IF NUMBER OF TAXA SETS IS GREATER THAN THE PREVIOUS MAXIMUM,
- REALLOCATE SPACE ACCORDINGLY
+ MAKE ROOM FOR THE TAXA SETS, AND FOR AS MANY ENTRIES AS COULD
+ FIT IN NBYTEB BYTES (EACH TAKES AT LEAST EIGHT)
 
 ****************************************************************/
 
-  if ( ntsets > ntsetsmax ) {
-
-   ntsetsmax= ntsets;
-   spacer(2);
-
-  }
+  taxfit(ntsets,nbyteb/8+1);
+  *ntstart= 0;
 
   if ( ntsets > 0 ) {
 
@@ -676,7 +804,9 @@ oclread()
     if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,(ntloc+j),
                missing)) == -1) return iend;
 
-    ntoff= maxtax * j;
+    ntoff= *(ntstart+j);
+    *(ntstart+j+1)= ntoff + *(ntloc+j);
+    taxfit(ntsets,*(ntstart+j+1));
 
 /**********************************************************
 
@@ -738,6 +868,21 @@ oclread()
 
  }
 
+/**********************************************************
+
+ HEADER DECODE TIME, LESS TIME SPENT WAITING FOR INPUT
+
+***********************************************************/
+
+ if ( statmode == 1 ) {
+  t= seconds();
+  statadd(0,t-t0-(runstats.tinput-tin));
+  t0= t;
+  tin= runstats.tinput;
+  runstats.nlevel += levels;
+  runstats.nvalue += nparm * levels;
+ }
+
 /**********************************************************
 
  READ IN EACH DEPTH VALUE, ERROR FLAG, AND ORIGINATORS FLAG
@@ -790,6 +935,7 @@ oclread()
     *(derr+doff+j)=0;
     *(doerr+doff+j)=0;
     *(drightfig+doff+j)=2;
+    runstats.nmissing++;
 
    }
 
@@ -805,6 +951,7 @@ oclread()
 ************************************************************/
 
  while ( ( i = fgetc(fp)) != '\n' && !feof(fp) );
+ if ( statmode == 1 ) statadd(1,seconds()-t0-(runstats.tinput-tin));
  return iend;
 
 }
@@ -987,7 +1134,7 @@ printstation(int i)
 
  for ( j=0; j < ntsets; j++ ) {
 
-  offs= j*maxtax; 
+  offs= *(ntstart+j);
 
   for ( k=0; k < *(ntloc+j); k++ ) {
 
@@ -1025,6 +1172,239 @@ printstation(int i)
 
 }
 
+/***************************************************************
+
+              FUNCTION DUMPCAST
+
+ DUMPCAST WRITES THE CAST AS COMMA DELIMITED RECORDS, ONE PER
+ LINE, EACH STARTING WITH A RECORD TYPE AND THE WOD UNIQUE CAST
+ NUMBER.  VALUES ARE WRITTEN AS THE INTEGERS READ, FOLLOWED BY
+ TOTAL FIGURES, SIGNIFICANT FIGURES AND FIGURES RIGHT OF THE
+ DECIMAL (VALUE / 10**RIGHTFIG IS THE VALUE); TOTAL FIGURES OF
+ ZERO MARK A MISSING VALUE.
+
+  H,CAST,CC,CRUISE,YEAR,MONTH,DAY,HOUR(4),LAT(4),LON(4),LEVELS,
+    ISOOR,NPARM
+  P,CAST,VARIABLE,PROFILE ERROR FLAG
+  O,CAST,1,ORIGINATORS CRUISE CODE  (2: STATION CODE)
+  I,CAST,VARIABLE,PRIMARY INVESTIGATOR
+  S,CAST,CODE,VALUE(4)               SECONDARY HEADER
+  V,CAST,VARIABLE,CODE,VALUE(4)      VARIABLE SPECIFIC SECONDARY HEADER
+  B,CAST,CODE,VALUE(4)               BIOLOGY HEADER
+  T,CAST,SET,CODE,VALUE(4),ERR,OERR  TAXA SET ENTRY
+  Z,CAST,LEVEL,DEPTH(4),ERR,OERR, THEN VALUE(4),ERR,OERR FOR EACH
+    VARIABLE IN THE ORDER OF THE P RECORDS
+
+ STANDARD LEVEL DEPTHS OF THE OLDER FORMATS CARRY NO FIGURES AND
+ ARE WRITTEN AS WHOLE METRES WITH EMPTY FIGURE FIELDS.
+
+***************************************************************/
+
+dumpcast()
+
+{
+
+ int j, k, offs;
+
+ dumpint('H',0);
+ dumpchar(cc,2);
+ dumpint(icruise,1);
+ dumpint(year,1);
+ dumpint(month,1);
+ dumpint(day,1);
+ dumpval(hour,*htotfig,*hsigfig,*hrightfig);
+ dumpval(latitude,*(htotfig+1),*(hsigfig+1),*(hrightfig+1));
+ dumpval(longitude,*(htotfig+2),*(hsigfig+2),*(hrightfig+2));
+ dumpint(levels,1);
+ dumpint(isoor,1);
+ dumpint(nparm,1);
+ dumpend();
+
+ for ( j = 0; j < nparm; j++ ) {
+  dumpint('P',0);
+  dumpint(*(ip2+j),1);
+  dumpint(*(iperror+j),1);
+  dumpend();
+ }
+
+ if ( origcfig > 0 ) {
+  dumpint('O',0);
+  dumpint(1,1);
+  dumpchar(origc,origcfig);
+  dumpend();
+ }
+ if ( origsfig > 0 ) {
+  dumpint('O',0);
+  dumpint(2,1);
+  dumpchar(origs,origsfig);
+  dumpend();
+ }
+
+ for ( j = 0; j < npi; j++ ) {
+  dumpint('I',0);
+  dumpint(*(ipip+j),1);
+  dumpint(*(ipi+j),1);
+  dumpend();
+ }
+
+ for ( j = 0; j < nsec; j++ ) {
+  dumpint('S',0);
+  dumpint(*(seccode+j),1);
+  dumpval(*(secval+j),*(stotfig+j),*(ssigfig+j),*(srightfig+j));
+  dumpend();
+ }
+
+ for ( j = 0; j < npsec; j++ ) {
+  dumpint('V',0);
+  dumpint(*(psecparm+j),1);
+  dumpint(*(pseccode+j),1);
+  dumpval(*(psecval+j),*(pstotfig+j),*(pssigfig+j),*(psrightfig+j));
+  dumpend();
+ }
+
+ for ( j = 0; j < nbio; j++ ) {
+  dumpint('B',0);
+  dumpint(*(biocode+j),1);
+  dumpval(*(bioval+j),*(btotfig+j),*(bsigfig+j),*(brightfig+j));
+  dumpend();
+ }
+
+ for ( j = 0; j < ntsets; j++ ) {
+  offs= *(ntstart+j);
+  for ( k = offs; k < offs + *(ntloc+j); k++ ) {
+   dumpint('T',0);
+   dumpint(j+1,1);
+   dumpint(*(ntcode+k),1);
+   dumpval(*(ntval+k),*(nttotfig+k),*(ntsigfig+k),*(ntrightfig+k));
+   dumpint(*(nterr+k),1);
+   dumpint(*(ntoerr+k),1);
+   dumpend();
+  }
+ }
+
+ for ( k = 0; k < levels; k++ ) {
+
+  dumpint('Z',0);
+  dumpint(k+1,1);
+  if ( iVERSflag != 2 && isoor != 0 ) {
+   dumpint(*(depth+k),1);
+   dumpchar(",,",2);
+   dumpint(0,1);
+   dumpint(0,1);
+  }
+  else {
+   dumpval(*(depth+k),*(ztotfig+k),*(zsigfig+k),*(zrightfig+k));
+   dumpint(*(zerr+k),1);
+   dumpint(*(zoerr+k),1);
+  }
+
+  for ( j = 0; j < nparm; j++ ) {
+   offs= j * levels + k;
+   dumpval(*(dataval+offs),*(dtotfig+offs),*(dsigfig+offs),
+           *(drightfig+offs));
+   dumpint(*(derr+offs),1);
+   dumpint(*(doerr+offs),1);
+  }
+
+  dumpend();
+
+ }
+
+}
+
+/***************************************************************
+
+              FUNCTION DUMPINT
+
+ DUMPINT ADDS INTEGER VALUE TO THE DUMP RECORD, AFTER A COMMA IF
+ COMMA IS SET.  CALLED WITH COMMA ZERO, VALUE IS THE RECORD TYPE
+ CHARACTER AND THE CAST NUMBER FOLLOWS IT.
+
+***************************************************************/
+
+dumpint(int value, int comma)
+
+{
+
+ char digits[12];
+ unsigned int u;
+ int n=0;
+
+ if ( comma == 0 ) {
+  *(dumpp++)= value;
+  value= ostation;
+ }
+
+ *(dumpp++)= ',';
+ if ( value < 0 ) *(dumpp++)= '-';
+ u= ( value < 0 ) ? -(unsigned int)value : value;
+
+ do {
+  *(digits+(n++))= '0' + u % 10;
+  u /= 10;
+ } while ( u > 0 );
+
+ while ( n > 0 ) *(dumpp++)= *(digits+(--n));
+
+}
+
+/***************************************************************
+
+              FUNCTION DUMPVAL
+
+ DUMPVAL ADDS A VALUE AND ITS TOTAL, SIGNIFICANT AND RIGHT OF
+ DECIMAL FIGURES TO THE DUMP RECORD
+
+***************************************************************/
+
+dumpval(int value, int totfig, int sigfig, int rightfig)
+
+{
+
+ dumpint(value,1);
+ dumpint(totfig,1);
+ dumpint(sigfig,1);
+ dumpint(rightfig,1);
+
+}
+
+/***************************************************************
+
+              FUNCTION DUMPCHAR
+
+ DUMPCHAR ADDS N CHARACTERS OF CDATA TO THE DUMP RECORD, AFTER A
+ COMMA
+
+***************************************************************/
+
+dumpchar(char *cdata, int n)
+
+{
+
+ *(dumpp++)= ',';
+ memcpy(dumpp,cdata,n);
+ dumpp += n;
+
+}
+
+/***************************************************************
+
+              FUNCTION DUMPEND
+
+ DUMPEND ENDS THE DUMP RECORD AND WRITES IT OUT
+
+***************************************************************/
+
+dumpend()
+
+{
+
+ *(dumpp++)= '\n';
+ fwrite(dumpline,1,dumpp-dumpline,fpout);
+ dumpp= dumpline;
+
+}
+
 /************************************************************
 
  SPACER.C SETS UP ORIGINAL SPACING FOR ALL DYNAMIC ARRAYS
@@ -1034,9 +1414,9 @@ printstation(int i)
 spacer(
  
  int intime      /* SET TO ONE TO INITIALIZE ALL DYNAMIC ARRAYS,
-                    SET TO TWO TO REDIMENSION TAXA ARRAYS,
                     SET TO THREE TO REDIMENSION DEPTH, 
                     SET TO FOUR TO REDIMENSION MEASURED VARIABLE ARRAYS
+                    (TAXA ARRAYS ARE REDIMENSIONED BY TAXFIT)
                  */
 
       )
@@ -1051,33 +1431,10 @@ spacer(
 
 ****************************************************************/
 
-  ntsets=1;
-  ntsetsmax=1;
-  if ( (ntcode =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntloc =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nttotfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntsigfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntrightfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntval =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nterr =calloc( ntsets * maxtax, sizeof(int)) )
-        == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntoerr =calloc( ntsets * maxtax, sizeof(int)) )
-        == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
- 
+  ntsetsmax= 0;
+  ntentmax= 0;
+  taxfit(1,maxtax);
+
 /***************************************************************
 
  ALLOCATE SPACE FOR DEPTH AND MEASURED VARIABLES
@@ -1128,42 +1485,6 @@ spacer(
  
  }
 
-/***************************************************************
-
- REALLOCATE SPACE FOR TAXA DATA
-
-****************************************************************/
-
- else if ( intime == 2 ) {
-
-   ntsetsmax = ntsets;
-   if ( (ntcode =realloc( ntcode, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntloc =realloc( ntloc, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nttotfig =realloc( nttotfig, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntsigfig =realloc( ntsigfig, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntrightfig =realloc( ntrightfig, ntsets * maxtax * sizeof(int)))
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntval =realloc( ntval, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nterr =realloc( nterr, ntsets * maxtax * sizeof(int)) )
-         == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntoerr =realloc( ntoerr, ntsets * maxtax * sizeof(int)) )
-         == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-
- }
-
 /***********************************************************
 
  REALLOCATE SPACE FOR DEPTH
@@ -1223,6 +1544,61 @@ spacer(
  }
 
 }
+/**********************************************************
+
+                 FUNCTION TAXFIT
+
+ TAXFIT MAKES SURE THERE IS ROOM FOR NS TAXA SETS HOLDING NE
+ ENTRIES IN ALL.  THE ENTRIES OF ALL SETS ARE PACKED END TO END
+ (SET J HOLDS ENTRIES NTSTART(J) TO NTSTART(J+1)-1), AND ALL TAXA
+ ARRAYS ARE CUT FROM ONE BLOCK, WHICH IS REPLACED BY ONE AT LEAST
+ TWICE THE SIZE, KEEPING ITS CONTENTS, WHEN IT IS OUTGROWN.  IF
+ THE SPACE CANNOT BE HAD THE PROGRAM STOPS.
+
+***********************************************************/
+
+taxfit(int ns, int ne)
+
+{
+
+ static int **entry[] = { &ntcode, &ntval, &nterr, &ntoerr, &nttotfig,
+                          &ntsigfig, &ntrightfig };
+ int *old= taxblock;
+ int k;
+
+ if ( ns <= ntsetsmax && ne <= ntentmax ) return 0;
+
+ if ( ns < ntsetsmax ) ns= ntsetsmax;
+ else if ( ns > ntsetsmax && ns < 2 * ntsetsmax ) ns= 2 * ntsetsmax;
+ if ( ne < ntentmax ) ne= ntentmax;
+ else if ( ne > ntentmax && ne < 2 * ntentmax ) ne= 2 * ntentmax;
+
+ if ( (taxblock = calloc(2L * ns + 1 + 7L * ne, sizeof(int))) == NULL ) {
+  printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ns);
+  exit(1);
+ }
+
+ if ( old != NULL ) {
+  memcpy(taxblock,ntloc,ntsetsmax * sizeof(int));
+  memcpy(taxblock+ns,ntstart,(ntsetsmax+1) * sizeof(int));
+ }
+ ntloc= taxblock;
+ ntstart= ntloc + ns;
+
+ for ( k = 0; k < 7; k++ ) {
+  if ( old != NULL )
+   memcpy(ntstart+ns+1+k*ne,*(*(entry+k)),ntentmax * sizeof(int));
+  *(*(entry+k))= ntstart + ns + 1 + k * ne;
+ }
+
+ free(old);
+ ntsetsmax= ns;
+ ntentmax= ne;
+
+ return 0;
+
+}
+
 /**********************************************************
 
                  FUNCTION EXTRACTI
@@ -1274,7 +1650,7 @@ extracti(
 
 {
 
- int sign,j,i;
+ int sign,j,i=0;
 
 /********************************************************
 
@@ -1440,3 +1816,141 @@ nocrfgetc()
  return i;
 
 } 
+/***************************************************************
+
+              FUNCTION SECONDS
+
+ SECONDS RETURNS THE TIME IN SECONDS FROM A MONOTONIC CLOCK
+
+***************************************************************/
+
+double seconds()
+
+{
+
+ struct timespec ts;
+
+ clock_gettime(CLOCK_MONOTONIC,&ts);
+ return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATREAD
+
+ STATREAD READS FROM THE WOD FILE FOR THE INPUT STREAM, TIMING
+ AND COUNTING EVERY READ, SO TIME WAITING FOR INPUT IS KEPT
+ APART FROM DECODING TIME
+
+***************************************************************/
+
+ssize_t statread(void *cookie, char *buf, size_t n)
+
+{
+
+ double t0= seconds();
+ ssize_t r= read(*(int *)cookie,buf,n);
+
+ runstats.tinput += seconds() - t0;
+ if ( r > 0 ) runstats.nread += r;
+ return r;
+
+}
+
+int statclose(void *cookie)
+
+{
+
+ return close(*(int *)cookie);
+
+}
+
+/***************************************************************
+
+              FUNCTION STATADD
+
+ STATADD ADDS THE TIME ONE CAST SPENT IN A STAGE (0 HEADER
+ DECODE, 1 LEVEL DECODE, 2 FORMAT, 3 WRITE) TO THE STAGE TOTAL
+ AND TO THE LATENCY HISTOGRAM OF THE STAGE
+
+***************************************************************/
+
+statadd(int stage, double t)
+
+{
+
+ long us= t * 1.e6;
+ int b= 0;
+
+ if ( stage == 0 ) runstats.theader += t;
+ else if ( stage == 1 ) runstats.tlevel += t;
+ else if ( stage == 2 ) runstats.tformat += t;
+ else runstats.twrite += t;
+
+ while ( us > 0 && b < nbucket-1 ) {
+  us >>= 1;
+  b++;
+ }
+ runstats.hist[stage][b]++;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATREPORT
+
+ STATREPORT PRINTS THE RUN STATISTICS
+
+***************************************************************/
+
+statreport(double elapsed)
+
+{
+
+ static char *stage[] = { "INPUT", "HEADER DECODE", "LEVEL DECODE",
+                          "FORMAT", "OUTPUT WRITE" };
+ double t[5], tsum= 0.;
+ long lo;
+ int j, b, bmax= 0;
+
+ *t= runstats.tinput;
+ *(t+1)= runstats.theader;
+ *(t+2)= runstats.tlevel;
+ *(t+3)= runstats.tformat;
+ *(t+4)= runstats.twrite;
+ for ( j = 0; j < 5; j++ ) tsum += *(t+j);
+ if ( tsum <= 0. ) tsum= 1.e-9;
+
+ printf("\n RUN STATISTICS\n");
+ printf(" CASTS READ      %14ld\n",runstats.ncast);
+ printf(" LEVELS          %14ld\n",runstats.nlevel);
+ printf(" VALUES          %14ld\n",runstats.nvalue);
+ printf(" MISSING VALUES  %14ld\n",runstats.nmissing);
+ printf(" BYTES READ      %14ld\n",runstats.nread);
+ printf(" BYTES WRITTEN   %14ld\n",runstats.nwrite);
+
+ printf("\n STAGE              SECONDS  PERCENT\n");
+ for ( j = 0; j < 5; j++ )
+  printf(" %-14s %11.4f %8.1f\n",*(stage+j),*(t+j),100. * *(t+j) / tsum);
+ printf(" %-14s %11.4f\n","ELAPSED",elapsed);
+
+ for ( j = 0; j < nstage; j++ )
+  for ( b = 0; b < nbucket; b++ )
+   if ( runstats.hist[j][b] > 0 && b > bmax ) bmax= b;
+
+ printf("\n CASTS BY LATENCY PER STAGE\n");
+ printf(" MICROSECONDS        HEADER     LEVELS     FORMAT      WRITE\n");
+ for ( b = 0; b <= bmax; b++ ) {
+  lo= ( b == 0 ) ? 0 : 1L << (b-1);
+  if ( b == nbucket-1 ) printf(" %8ld OR MORE ",lo);
+  else printf(" %8ld - %-7ld",lo,(1L << b) - 1);
+  for ( j = 0; j < nstage; j++ ) printf(" %10ld",runstats.hist[j][b]);
+  printf("\n");
+ }
+
+ return 0;
+
+}
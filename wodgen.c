@@ -0,0 +1,530 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/***********************************************************
+
+ WODGEN WRITES A FILE OF SYNTHETIC CASTS IN WOD NATIVE ('C')
+ FORMAT, FOR MEASURING THE SPEED OF THE READERS AND CONVERTERS
+ WITHOUT DEPENDING ON A PARTICULAR DOWNLOAD.
+
+ USAGE: wodgen OUTFILE NCAST [SEED]
+
+ THE CASTS ARE A MIX OF:
+
+  BOTTLE (OSD) CASTS - 5 TO 40 LEVELS, 3 TO 10 VARIABLES, WITH
+                       RARE TRACERS ON ABOUT ONE CAST IN TEN
+  CTD CASTS          - 100 TO 1500 LEVELS, 2 OR 3 VARIABLES
+  PLANKTON CASTS     - 1 TO 3 LEVELS WITH BIOLOGY HEADERS AND
+                       UP TO 40 TAXA SETS
+
+ WITH ORIGINATORS CRUISE/STATION CODES AND PRIMARY INVESTIGATORS
+ ON ABOUT HALF OF THE CASTS, SECONDARY HEADERS ON ALL, VARIABLE
+ SPECIFIC SECONDARY HEADERS ON SOME, AND A FEW MISSING VALUES.
+ CASTS ARE IN TIME ORDER THROUGH ONE YEAR, AS IN WOD FILES.
+
+ THE SAME SEED ALWAYS GIVES THE SAME FILE.
+
+************************************************************/
+
+/***********************************************************
+
+ DEFINED CONSTANTS
+
+ MAXCAST: MAXIMUM NUMBER OF BYTES IN ONE GENERATED CAST
+ LINELEN: NUMBER OF CHARACTERS ON EACH LINE OF A WOD FILE
+
+************************************************************/
+
+#define maxcast 4000000
+#define linelen 80
+
+/**********************************************************
+
+ *FPOUT - FILE TO BE OPENED FOR WRITING SYNTHETIC CASTS
+
+ CAST - BYTES OF THE CAST BEING GENERATED (AFTER THE BYTE COUNT)
+ NCAST - NUMBER OF BYTES IN CAST SO FAR
+ SEED - STATE OF THE RANDOM NUMBER GENERATOR
+
+***********************************************************/
+
+FILE *fpout;
+
+char *cast;
+int ncast;
+unsigned long seed=1;
+
+/**********************************************************
+
+ VARIABLE CODES USED FOR EACH KIND OF CAST
+
+***********************************************************/
+
+ int osdvars[] = { 1, 2, 3, 4, 6, 8, 9, 11, 17, 20, 21 };
+ int rarevars[] = { 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43 };
+ int ctdvars[] = { 1, 2, 3 };
+ char *countries[] = { "US", "JP", "DE", "FI", "DK", "RU", "GB", "CA",
+                       "FR", "NO" };
+
+main(int argc, char **argv)
+
+{
+
+ int i, n, nbytet, nfig;
+ long nbytes=0;
+ char count[16];
+
+ if ( argc < 3 ) {
+  printf("USAGE: %s OUTFILE NCAST [SEED]\n",argv[0]);
+  return 1;
+ }
+
+ n= atoi(argv[2]);
+ if ( argc > 3 ) seed= strtoul(argv[3],NULL,10);
+
+ if ((fpout = fopen(argv[1],"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",argv[1]);
+  return 1;
+ }
+
+ if ( (cast = malloc(maxcast)) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR CAST\n");
+  return 1;
+ }
+
+ for ( i = 0; i < n; i++ ) {
+
+  ncast= 0;
+  makecast(i,n);
+
+/**********************************************************
+
+ THE BYTE COUNT INCLUDES THE FORMAT CODE AND ITSELF
+
+***********************************************************/
+
+  nbytet= ncast + 3;
+  for ( nfig = 1; ; nfig++ ) {
+   sprintf(count,"%d",nbytet + nfig - 1);
+   if ( strlen(count) == nfig ) break;
+  }
+  nbytet += nfig - 1;
+
+  writecast(nbytet);
+  nbytes += nbytet;
+
+ }
+
+ if ( fclose(fpout) != 0 ) {
+  printf("UNABLE TO WRITE FILE %s\n",argv[1]);
+  return 1;
+ }
+
+ printf(" %d CASTS, %ld BYTES OF CAST DATA WRITTEN TO %s\n",n,nbytes,
+  argv[1]);
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION RANDINT
+
+ RANDINT RETURNS A RANDOM INTEGER FROM LO TO HI (INCLUSIVE)
+
+***************************************************************/
+
+randint(int lo, int hi)
+
+{
+
+ seed= seed * 6364136223846793005UL + 1442695040888963407UL;
+ return lo + (int)( ( seed >> 33 ) % (unsigned long)( hi - lo + 1 ) );
+
+}
+
+/***************************************************************
+
+              FUNCTION PUTCH
+
+ PUTCH ADDS ONE CHARACTER TO THE CAST
+
+***************************************************************/
+
+putch(int c)
+
+{
+
+ if ( ncast < maxcast ) *(cast+ncast++)= c;
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PUTINT
+
+ PUTINT ADDS AN INTERNAL INTEGER: NUMBER OF FIGURES, THEN VALUE
+
+***************************************************************/
+
+putint(int value)
+
+{
+
+ char s[16];
+ int j;
+
+ sprintf(s,"%d",value);
+ putch('0' + strlen(s));
+ for ( j = 0; *(s+j) != '\0'; j++ ) putch(*(s+j));
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PUTFIX
+
+ PUTFIX ADDS AN INTEGER WITH A FIXED NUMBER OF FIGURES
+
+***************************************************************/
+
+putfix(int value, int totfig)
+
+{
+
+ char s[16];
+ int j;
+
+ sprintf(s,"%*d",totfig,value);
+ for ( j = 0; *(s+j) != '\0'; j++ ) putch(*(s+j));
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PUTVAL
+
+ PUTVAL ADDS A DATA VALUE: SIGNIFICANT FIGURES, TOTAL FIGURES,
+ FIGURES RIGHT OF THE DECIMAL, THEN THE VALUE TIMES 10**RIGHTFIG.
+ A NEGATIVE RIGHTFIG ADDS A MISSING VALUE.
+
+***************************************************************/
+
+putval(int value, int rightfig)
+
+{
+
+ char s[16];
+ int j, sigfig;
+
+ if ( rightfig < 0 ) return putch('-');
+
+ sprintf(s,"%d",value);
+ for ( sigfig= 0, j = 0; *(s+j) != '\0'; j++ )
+  if ( *(s+j) != '-' && ( sigfig > 0 || *(s+j) != '0' ) ) sigfig++;
+ if ( sigfig == 0 ) sigfig= 1;
+
+ putch('0' + sigfig);
+ putch('0' + strlen(s));
+ putch('0' + rightfig);
+ for ( j = 0; *(s+j) != '\0'; j++ ) putch(*(s+j));
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION MAKECAST
+
+ MAKECAST GENERATES CAST NUMBER ICAST OF NCASTS, EVERYTHING
+ AFTER THE BYTE COUNT
+
+***************************************************************/
+
+makecast(int icast, int ncasts)
+
+{
+
+ int kind, levels, nparm, ip2[20], nvar, j, k, m, dup;
+ int nbio, ntsets, nloc, nsec, npsec, npi, ninfc;
+ int depth, yday, month, day;
+ char orig[32];
+ int mark;
+ static int mdays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/**********************************************************
+
+ KIND OF CAST: 0 BOTTLE, 1 CTD, 2 PLANKTON
+
+***********************************************************/
+
+ k= randint(0,99);
+ kind= ( k < 60 ) ? 0 : ( k < 90 ) ? 1 : 2;
+
+ if ( kind == 0 ) {
+  levels= randint(5,40);
+  nvar= randint(3,10);
+  for ( nparm = 0; nparm < nvar; nparm++ )
+   *(ip2+nparm)= *(osdvars+nparm);
+  if ( randint(0,9) == 0 ) {
+   for ( j = randint(1,5); j > 0; j-- )
+    *(ip2+nparm++)= *(rarevars+randint(0,10));
+  }
+ }
+ else if ( kind == 1 ) {
+  levels= randint(100,1500);
+  nparm= randint(2,3);
+  for ( j = 0; j < nparm; j++ ) *(ip2+j)= *(ctdvars+j);
+ }
+ else {
+  levels= randint(1,3);
+  nparm= 0;
+ }
+
+/**********************************************************
+
+ DROP REPEATED RARE TRACER CODES
+
+***********************************************************/
+
+ for ( j = 0, m = 0; j < nparm; j++ ) {
+  for ( dup = 0, k = 0; k < m; k++ ) if ( *(ip2+k) == *(ip2+j) ) dup= 1;
+  if ( !dup ) *(ip2+m++)= *(ip2+j);
+ }
+ nparm= m;
+
+/**********************************************************
+
+ CAST NUMBER, COUNTRY, CRUISE, DATE, TIME, POSITION
+
+***********************************************************/
+
+ putint(20000000 + icast);
+ k= randint(0,9);
+ putch(**(countries+k));
+ putch(*(*(countries+k)+1));
+ putint(randint(1,99999));
+
+ yday= (int)( (long)icast * 365 / ( ncasts > 0 ? ncasts : 1 ) );
+ for ( month = 0; month < 11 && yday >= *(mdays+month); month++ )
+  yday -= *(mdays+month);
+ day= yday + 1;
+ putfix(2017,4);
+ putfix(month+1,2);
+ putfix(day,2);
+
+ if ( randint(0,19) == 0 ) putval(0,-1);
+ else putval(randint(0,2399),2);
+ putval(randint(-89999,89999),3);
+ putval(randint(-179999,179999),3);
+
+ putint(levels);
+ putfix(0,1);
+ putfix(nparm,2);
+
+/**********************************************************
+
+ VARIABLE CODES, PROFILE FLAGS, VARIABLE SPECIFIC SECONDARY
+ HEADERS
+
+***********************************************************/
+
+ for ( j = 0; j < nparm; j++ ) {
+  putint(*(ip2+j));
+  putfix(( randint(0,19) == 0 ) ? randint(1,9) : 0,1);
+  npsec= ( randint(0,3) == 0 ) ? randint(1,3) : 0;
+  putint(npsec);
+  for ( k = 0; k < npsec; k++ ) {
+   putint(randint(1,30));
+   putval(randint(1,9999),0);
+  }
+ }
+
+/**********************************************************
+
+ ORIGINATORS CODES AND PRIMARY INVESTIGATORS: BYTE COUNT
+ COVERS THE FIELDS WHICH FOLLOW IT, A SINGLE ZERO IF NONE
+
+***********************************************************/
+
+ if ( randint(0,1) == 0 ) putch('0');
+ else {
+
+  putch('0');
+  mark= ncast;
+  ninfc= randint(1,3);
+  putfix(ninfc,1);
+  for ( j = 1; j <= ninfc; j++ ) {
+   putfix(j,1);
+   if ( j < 3 ) {
+    sprintf(orig,"%s%d",( j == 1 ) ? "CR" : "ST",randint(1,99999));
+    putfix(strlen(orig),2);
+    for ( k = 0; *(orig+k) != '\0'; k++ ) putch(*(orig+k));
+   }
+   else {
+    npi= randint(1,4);
+    putfix(npi,2);
+    for ( k = 0; k < npi; k++ ) {
+     putint(( nparm > 0 ) ? *(ip2+randint(0,nparm-1)) : 0);
+     putint(randint(1,999));
+    }
+   }
+  }
+  setcount(mark);
+
+ }
+
+/**********************************************************
+
+ SECONDARY HEADERS
+
+***********************************************************/
+
+ putch('0');
+ mark= ncast;
+ nsec= randint(3,12);
+ putint(nsec);
+ for ( j = 0; j < nsec; j++ ) {
+  putint(randint(1,99));
+  if ( randint(0,2) == 0 ) putval(randint(1,99999),2);
+  else putval(randint(1,9999),0);
+ }
+ setcount(mark);
+
+/**********************************************************
+
+ BIOLOGY HEADERS AND TAXA SETS
+
+***********************************************************/
+
+ if ( kind != 2 ) putch('0');
+ else {
+
+  putch('0');
+  mark= ncast;
+  nbio= randint(2,6);
+  putint(nbio);
+  for ( j = 0; j < nbio; j++ ) {
+   putint(randint(1,50));
+   putval(randint(1,9999),randint(0,2));
+  }
+  ntsets= randint(1,40);
+  putint(ntsets);
+  for ( j = 0; j < ntsets; j++ ) {
+   nloc= randint(3,15);
+   putint(nloc);
+   for ( k = 0; k < nloc; k++ ) {
+    putint(( k == 0 ) ? 1 : randint(2,30));
+    if ( k == 0 ) putval(randint(1000000,99999999),0);
+    else putval(randint(1,99999),randint(0,3));
+    putfix(0,1);
+    putfix(randint(0,9) == 0,1);
+   }
+  }
+  setcount(mark);
+
+ }
+
+/**********************************************************
+
+ LEVELS: DEPTH AND FLAGS, THEN EACH VARIABLE AND ITS FLAGS
+
+***********************************************************/
+
+ depth= randint(0,50);
+ for ( j = 0; j < levels; j++ ) {
+
+  putval(depth,1);
+  putfix(0,1);
+  putfix(0,1);
+  depth += ( kind == 1 ) ? randint(5,20) : randint(20,5000);
+
+  for ( k = 0; k < nparm; k++ ) {
+   if ( randint(0,19) == 0 ) putval(0,-1);
+   else {
+    putval(randint(-2000,350000),( *(ip2+k) <= 2 ) ? 4 : 2);
+    putfix(( randint(0,29) == 0 ) ? randint(1,9) : 0,1);
+    putfix(randint(0,9) == 0,1);
+   }
+  }
+
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION SETCOUNT
+
+ SETCOUNT FILLS IN THE BYTE COUNT PLACEHOLDER (A SINGLE '0')
+ JUST BEFORE MARK WITH THE NUMBER OF BYTES ADDED SINCE MARK,
+ MOVING THOSE BYTES TO MAKE ROOM FOR THE COUNT
+
+***************************************************************/
+
+setcount(int mark)
+
+{
+
+ char s[16];
+ int nbytes= ncast - mark, n;
+
+ sprintf(s,"%d",nbytes);
+ n= strlen(s);
+
+ if ( ncast + n >= maxcast ) return -1;
+ memmove(cast+mark+n,cast+mark,nbytes);
+ *(cast+mark-1)= '0' + n;
+ memcpy(cast+mark,s,n);
+ ncast += n;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION WRITECAST
+
+ WRITECAST WRITES THE FORMAT CODE, BYTE COUNT AND CAST AS LINES
+ OF LINELEN CHARACTERS, THE LAST LINE PADDED WITH BLANKS
+
+***************************************************************/
+
+writecast(int nbytet)
+
+{
+
+ char s[16], head[32];
+ int j, nhead, col=0;
+
+ snprintf(s,sizeof(s),"%d",nbytet);
+ snprintf(head,sizeof(head),"C%d%s",(int)strlen(s),s);
+ nhead= strlen(head);
+
+ for ( j = 0; j < nhead + ncast; j++ ) {
+  putc( ( j < nhead ) ? *(head+j) : *(cast+j-nhead), fpout);
+  if ( ++col == linelen ) {
+   putc('\n',fpout);
+   col= 0;
+  }
+ }
+
+ if ( col > 0 ) {
+  while ( col++ < linelen ) putc(' ',fpout);
+  putc('\n',fpout);
+ }
+
+ return 0;
+
+}
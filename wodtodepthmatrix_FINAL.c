@@ -1,6 +1,17 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <time.h>
 
 /***********************************************************
 
@@ -14,6 +25,7 @@
  IDIM: LONGITUDE DIMENSIONS
  JDIM: LATITUDE DIMENSIONS
  KDIM: STANDARD DEPTH LEVELS
+ SPLITMIN: SMALLEST BYTE RANGE OF A FILE WORTH A WORKER OF ITS OWN
 
 ************************************************************/
 
@@ -22,11 +34,18 @@
 #define maxbio 50
 #define maxparm 100
 #define maxpsec 25 * maxparm
+#define maxcast 16777216
 #define idim 360
 #define jdim 180
 #define kdim 102
 #define kdimax 137
 #define maxchoice 8
+#define maxname 1024
+#define maxunique 2147483647
+#define tblock 64
+#define nstage 4
+#define nbucket 24
+#define splitmin 1048576
 
 /**********************************************************
 
@@ -34,10 +53,12 @@
  *FPOUT - FILE TO BE OPENED FOR WRITING OUTPUT
  *FPLIST - FILE WITH LIST OF WOA FILES TO READ
  *FPWOA - WOA FILES TO READ IN
+ *FPPSEC - SIDE TABLE OF VARIABLE SPECIFIC SECONDARY HEADERS
 
 ***********************************************************/
 
 FILE *fp,*fpout,*fplist, *fpwoa;
+FILE *fppsec=NULL;
 
 /**********************************************************
 
@@ -57,13 +78,16 @@ FILE *fp,*fpout,*fplist, *fpwoa;
  HSIGFIG - NUMBER SIGNIFICANT FIGURES FOR 1: HOUR, 2: LATITUDE, 3: LONGITUDE
  HTOTFIG - NUMBER OF FIGURES TO THE RIGHT OF THE DECIMAL FOR
            1: HOUR, 2: LATITUDE, 3: LONGITUDE
+ NZREAD - NUMBER OF LEVELS DECODED (FEWER THAN LEVELS ONLY IN
+          INTERVAL MODE, SEE OCLREAD)
 
 **************************************************************/
 
-char cc[2];
+char cc[3];
 int icruise=0, ostation=0, year=0, month=0, day=0;
 int hour,longitude,latitude;
 int levels,isoor,nparm,ip2[maxparm],iperror[maxparm];
+int nzread=0;
 int htotfig[3],hsigfig[3],hrightfig[3];
 
 /*************************************************************
@@ -81,8 +105,13 @@ int htotfig[3],hsigfig[3],hrightfig[3];
  IPIP - VARIABLE FOR PRIMARY INVESTIGATOR
  IPI - PRIMARY INVESTIGATORY
 
+ PIINFO - SET TO ONE TO DECODE THE ORIGINATORS CODES AND PRIMARY
+          INVESTIGATORS, WHICH ARE NOT WRITTEN TO THE CSV FILE
+          (OTHERWISE THEY ARE SKIPPED USING THEIR BYTE COUNT)
+
 *****************************************************************/
 
+int piinfo=0;
 int origcfig,origsfig;
 char origc[30],origs[30];
 int ipip[maxparm],ipi[maxparm],npi;
@@ -98,8 +127,17 @@ int ipip[maxparm],ipi[maxparm],npi;
  SECCODE - SECONDARY HEADER CODE
  SECVAL - SECONDARY HEADER VALUE
 
+ SECINFO - SET TO ONE TO DECODE THE SECONDARY HEADERS (OTHERWISE
+           THEY ARE SKIPPED USING THEIR BYTE COUNT)
+ NSECCOL - NUMBER OF SECONDARY HEADERS WRITTEN AS CSV COLUMNS
+ SECCOL - CODE OF EACH SECONDARY HEADER WRITTEN AS A CSV COLUMN
+ SECROW - THOSE COLUMNS FOR THE PRESENT CAST, ADDED TO EACH ROW
+
 **************************************************************/
 
+int secinfo=0;
+int nseccol=0, seccol[maxsec];
+char secrow[maxsec*24];
 int nsec;
 int stotfig[maxsec],ssigfig[maxsec],srightfig[maxsec];
 int seccode[maxsec],secval[maxsec];
@@ -117,9 +155,14 @@ int seccode[maxsec],secval[maxsec];
  PSECPARM - VALUE OF VARIABLE SPECIFIC SECONDARY HEADER
  PSECCODE - VARIABLE SPECIFIC SECONDARY HEADER CODE
  PSECVAL - VARIABLE SPECIFIC SECONDARY HEADER VALUE
+ PSECOUT - SET TO ONE TO WRITE THEM TO A SIDE TABLE (NAME.PSEC.CSV)
+           ALONGSIDE THE CSV FILE
+ PSECHEAD - COLUMN HEADER OF THE SIDE TABLE
 
 **************************************************************/
 
+int psecout=0;
+char *psechead= "WOD_unique,Variable_code,Variable,Psec_code,Value";
 int npsec;
 int pstotfig[maxpsec],pssigfig[maxpsec],psrightfig[maxpsec];
 int psecparm[maxpsec],pseccode[maxpsec],psecval[maxpsec];
@@ -134,10 +177,13 @@ int psecparm[maxpsec],pseccode[maxpsec],psecval[maxpsec];
  BRIGHTFIG - NUMBER OF FIGURES RIGHT OF DECIMAL FOR EACH BIOLOGICAL HEADER 
  BIOCODE - BIOLOGICAL HEADER CODE
  BIOVAL - BIOLOGICAL HEADER VALUE
+ BIOLOGY - SET TO ONE TO DECODE THE BIOLOGICAL HEADER AND TAXA
+           SETS, WHICH ARE NOT WRITTEN TO THE CSV FILE (OTHERWISE
+           THEY ARE SKIPPED USING THEIR BYTE COUNT)
 
 **************************************************************/
 
-int nbio;
+int nbio, biology=0;
 int btotfig[maxbio],bsigfig[maxbio],brightfig[maxbio];
 int biocode[maxbio],bioval[maxbio];
 
@@ -147,6 +193,8 @@ int biocode[maxbio],bioval[maxbio];
 
  NTSETS - NUMBER OF TAXA SETS AT CAST
  NTLOC - NUMBER OF DELIMITORS FOR EACH TAXA SET
+ NTSTART - FIRST ENTRY OF EACH TAXA SET IN THE ARRAYS BELOW (THE
+           ENTRIES OF ALL SETS ARE PACKED END TO END)
  NTCODE - TAXA CODE FOR EACH TAXA VARIABLE
  NTVAL  - VALUE FOR EACH TAXA CODE
  NTERR - ERROR FLAG FOR EACH TAXA VALUE
@@ -159,6 +207,7 @@ int biocode[maxbio],bioval[maxbio];
 
 int ntsets;
 int *ntloc,*ntcode,*ntval,*nterr,*ntoerr,*nttotfig,*ntsigfig,*ntrightfig;
+int *ntstart;
 
 /*************************************************************
 
@@ -198,27 +247,333 @@ int *dataval,*derr,*doerr,*dtotfig,*dsigfig,*drightfig;
 
  ISIZE - PRESENT ARRAY SIZE NEEDED TO FIT ALL MEASURED VARIABLES
  ZSIZE - PRESENT ARRAY SIZE NEEDED TO FIT ALL DEPTHS
- NTSETSMAX - MAXIMUM NUMBER OF TAXA SETS
- ISIZEMAX - MAXIMUM ARRAY SIZE YET ENCOUNTERED FOR MEASURED VARIABLES
- ZSIZEMAX - MAXIMUM ARRAY SIZE YET ENCOUNTERED FOR DEPTHS
+ NTSETSMAX - SPACE ALLOCATED FOR TAXA SETS
+ NTENTMAX - SPACE ALLOCATED FOR TAXA SET ENTRIES (ALL SETS)
+ TAXBLOCK - SINGLE ALLOCATION HOLDING ALL TAXA ARRAYS
+ ISIZEMAX - SPACE ALLOCATED FOR MEASURED VARIABLES (VALUES)
+ ZSIZEMAX - SPACE ALLOCATED FOR DEPTHS
+ ZBLOCK - SINGLE ALLOCATION HOLDING ALL DEPTH AND MEASURED
+          VARIABLE ARRAYS
 
 /*************************************************************/
 
 int isize,zsize;
 int ntsetsmax=0, isizemax=0,zsizemax=0;
+int ntentmax=0;
+int *taxblock=NULL;
+int *zblock=NULL;
 
 /*************************************************************
 
  USER SET VARIABLES
 
- XCHOICE - CHOICE OF DEPTH SLICES
+ XCHOICE - CHOICE OF DEPTH SLICES: A ALL LEVELS, S SURFACE (FIRST
+           LEVEL WRITTEN), B BOTTOM (LAST), I INTERVAL
  XINTERV1,XINTERV2 - SHALLOWEST/DEEPEST DEPTHS REQUESTED
+ VCHOICE - VARIABLE REQUESTED (0 FOR ALL).  A CAST WITHOUT IT IS
+           SKIPPED AS SOON AS ITS VARIABLE LIST HAS BEEN READ
+
+*************************************************************/
+
+char xchoice[2]="A";
+int vchoice=0;
+
+/*************************************************************
+
+ OUTPUT
+
+ PRINTROWS - OUTPUT KERNEL FOR THE DEPTH MODE AND VARIABLE CHOICE
+             OF THE RUN (SEE PICKKERNEL)
+ ROWHEAD - HEADER COLUMNS OF EACH ROW OF THE PRESENT CAST
+ VARCOL - FOR EACH VARIABLE CODE (LESS ONE), ITS POSITION IN IP2
+          AT THE PRESENT CAST, -1 IF ABSENT
+
+*************************************************************/
+
+int (*printrows)(int);
+char rowhead[128];
+int varcol[maxparm];
+
+/*************************************************************
+
+ QUALITY CONTROL FILTER
+
+ QCZ, QCD, QCP - WOD FLAGS ACCEPTED FOR DEPTHS (ZERR), VALUES
+                 (DERR) AND PROFILES (IPERROR), BIT F SET TO
+                 ACCEPT FLAG F; ALL BITS SET ACCEPTS EVERYTHING
+ QCMODE - SET TO ONE WHEN ANY OF THEM ACCEPTS LESS THAN EVERYTHING
+ PROFOK - FOR EACH VARIABLE AT THE CAST, ONE IF ITS PROFILE FLAG
+          IS ACCEPTED.  A VARIABLE WHOSE PROFILE IS REJECTED IS
+          WRITTEN AS ABSENT, AND A CAST LEFT WITH NO VARIABLE IS
+          SKIPPED AS SOON AS ITS VARIABLE LIST HAS BEEN READ.
+          A LEVEL WHOSE DEPTH IS REJECTED, OR WHICH HAS NO VALUE
+          ACCEPTED, IS NOT WRITTEN; A REJECTED OR MISSING VALUE IS
+          WRITTEN EMPTY.
 
 *************************************************************/
 
-char xchoice[2];
+int qcz= ~0, qcd= ~0, qcp= ~0;
+int qcmode=0;
+int profok[maxparm];
 float xinterv1,xinterv2;
 
+/*************************************************************
+
+ BATCH CONVERSION
+
+ INPUTS - NAMES OF WOD FILES TO CONVERT
+ INPUTSIZE - SIZE IN BYTES OF EACH WOD FILE
+ NINPUT - NUMBER OF WOD FILES TO CONVERT
+ NINPUTMAX - PRESENT SIZE OF INPUTS AND INPUTSIZE ARRAYS
+ NINPUTFAIL - NUMBER OF INPUT FILES, DIRECTORIES OR LISTS WHICH
+              COULD NOT BE READ (THE RUN THEN FAILS)
+ NOHEADER - SET TO ONE TO OMIT THE COLUMN HEADER (MERGED OUTPUT)
+
+*************************************************************/
+
+char **inputs=NULL;
+long *inputsize=NULL;
+int ninput=0, ninputmax=0, ninputfail=0;
+int noheader=0;
+
+/*************************************************************
+
+ DUPLICATE CASTS
+
+ DEDUP - SET TO ONE TO SKIP CASTS WHOSE WOD UNIQUE NUMBER HAS
+         ALREADY BEEN CONVERTED
+ SEENCAST - ONE BIT FOR EACH WOD UNIQUE NUMBER ALREADY CONVERTED,
+            SHARED BY ALL WORKER PROCESSES
+ NDUPLICATE - NUMBER OF DUPLICATE CASTS SKIPPED
+ NBADCAST - NUMBER OF BAD CASTS SKIPPED (SEE BADCAST)
+ CASTBYTES - NUMBER OF BYTES OF THE PRESENT CAST READ SO FAR
+ FILESIZE - SIZE OF THE FILE BEING READ (0 IF NOT KNOWN), SO A
+            BYTE COUNT RUNNING PAST ITS END IS CAUGHT
+
+*************************************************************/
+
+int dedup=0, nduplicate=0, castbytes=0;
+int nbadcast=0;
+long filesize=0;
+
+/*************************************************************
+
+ SPECULATIVE SPLIT OF ONE FILE (-P)
+
+ NSPLIT - NUMBER OF BYTE RANGES, EACH CONVERTED BY ITS OWN WORKER,
+          A SINGLE WOD FILE IS SPLIT INTO
+ RANGEFROM, RANGETO - CONVERTFILE CONVERTS ONLY THE CASTS STARTING
+                      FROM BYTE RANGEFROM UP TO BYTE RANGETO (ZERO
+                      FOR THE WHOLE FILE)
+ RANGESTOP - WHERE CONVERTFILE STOPPED: THE START OF THE FIRST
+             CAST NOT CONVERTED, OR THE END OF THE FILE
+ SPLITRANGE - ONE BYTE RANGE: FIRST IS THE CAST START THE WORKER
+              FOUND AT OR AFTER START, STOP IS RANGESTOP.  THE
+              RANGES JOIN UP ONLY IF EACH FIRST IS THE STOP OF THE
+              RANGE BEFORE IT.
+
+*************************************************************/
+
+struct splitrange {
+ long start, end;
+ long first, stop;
+};
+
+int nsplit=1;
+long rangefrom=0, rangeto=0, rangestop=0;
+unsigned int *seencast=NULL;
+
+/*************************************************************
+
+ PARTITIONED OUTPUT
+
+ PARTMODE - 'M' TO SPLIT OUTPUT INTO ONE FILE PER YEAR AND MONTH,
+            'W' INTO ONE FILE PER WMO 10 DEGREE SQUARE, ZERO FOR
+            A SINGLE OUTPUT FILE
+ PARTMEM - BYTES OF CONVERTED CASTS HELD IN MEMORY BEFORE A SORTED
+           RUN IS WRITTEN TO DISK
+ RUNBASE - NAME PREFIX FOR RUN FILES WRITTEN BY THIS PROCESS
+ NRUN - NUMBER OF RUN FILES WRITTEN SO FAR
+ PARTFAIL - SET TO ONE ONCE A RUN FILE COULD NOT BE WRITTEN; NO
+            MORE RUNS ARE WRITTEN AND THOSE WRITTEN ARE DROPPED
+ RUNBUF - CONVERTED CASTS (PARTREC HEADER FOLLOWED BY CSV ROWS)
+ RUNUSED, RUNSIZE - BYTES USED AND ALLOCATED IN RUNBUF
+ RUNREC - OFFSET OF EACH CAST IN RUNBUF
+ NRUNREC, NRUNRECMAX - CASTS IN RUNBUF AND SIZE OF RUNREC
+ FPCAST - MEMORY STREAM RECEIVING THE ROWS OF THE PRESENT CAST
+
+*************************************************************/
+
+struct partrec {
+ int part;                /* MONTH (YYYYMM) OR WMO SQUARE */
+ int tkey;                /* YYYYMMDD */
+ int hkey;                /* HOUR IN HUNDREDTHS, -1 IF NOT GIVEN */
+ int id;                  /* WOD UNIQUE CAST NUMBER */
+ int seq;                 /* ORDER IN WHICH CAST WAS CONVERTED */
+ int len;                 /* BYTES OF CSV ROWS WHICH FOLLOW */
+};
+
+int partmode=0;
+long partmem= 256L * 1024L * 1024L;
+char runbase[maxname];
+int nrun=0, partfail=0;
+char *runbuf=NULL;
+long runused=0, runsize=0;
+long *runrec=NULL;
+int nrunrec=0, nrunrecmax=0;
+FILE *fpcast=NULL;
+char *castbuf=NULL;
+size_t castlen=0;
+
+/*************************************************************
+
+ SPATIAL INDEX
+
+ CASTIDX - ONE INDEX ENTRY PER CAST, KEPT SORTED BY Z-ORDER KEY
+ IDXHEAD - HEADER OF INDEX FILE (WODFILE.SDX), WITH THE SIZE AND
+           MODIFICATION TIME OF THE WOD FILE IT WAS BUILT FROM
+ INDEXONLY - SET TO ONE TO BUILD INDEX FILES INSTEAD OF CONVERTING
+ HDRONLY - SET TO ONE FOR OCLREAD TO DECODE ONLY THROUGH THE
+           POSITION AND SKIP THE REST OF THE CAST, TWO TO DECODE
+           THROUGH THE VARIABLE CODES (FOR THE INVENTORY)
+ INVMODE - SET TO ONE TO WRITE ONE INVENTORY ROW PER CAST (PRINTINV)
+           INSTEAD OF CONVERTING ITS LEVELS
+ CASTOFFSET - BYTE OFFSET OF THE PRESENT CAST IN THE WOD FILE
+ SQUERY - SET TO ONE TO CONVERT ONLY CASTS INSIDE THE QUERY BOX
+ QLAT1,QLAT2,QLON1,QLON2 - QUERY BOX (DEGREES)
+ QLAT0,QLON0,QKM - QUERY CIRCLE CENTER (DEGREES) AND RADIUS (KM),
+                   QKM ZERO FOR A BOX QUERY
+ CASTSPAN - NCAST CASTS STARTING AT A BYTE OFFSET, SELECTED FOR
+            CONVERSION BY AN INDEX QUERY
+
+*************************************************************/
+
+struct castidx {
+ unsigned int zkey;       /* Z-ORDER KEY OF LATITUDE/LONGITUDE CELL */
+ int lat, lon;            /* POSITION, THOUSANDTHS OF A DEGREE */
+ int date;                /* YYYYMMDD */
+ int hour;                /* HOUR IN HUNDREDTHS, -1 IF NOT GIVEN */
+ int id;                  /* WOD UNIQUE CAST NUMBER */
+ long offset;             /* BYTE OFFSET OF CAST IN WOD FILE */
+};
+
+struct idxhead {
+ char magic[8];
+ long ncast, fsize, mtime;
+};
+
+struct castspan {
+ long offset;
+ long ncast;
+};
+
+int indexonly=0, hdronly=0, squery=0, invmode=0;
+long castoffset=0;
+double qlat1,qlat2,qlon1,qlon2,qlat0,qlon0,qkm=0.;
+
+/*************************************************************
+
+ TIME INDEX
+
+ TIMEBLK - ONE INDEX ENTRY PER BLOCK OF TBLOCK CONSECUTIVE CASTS
+           WITH THE EARLIEST AND LATEST TIME IN THE BLOCK (THE
+           TIME INDEX, WODFILE.TDX, IS IN FILE ORDER)
+ TQUERY - SET TO ONE TO CONVERT ONLY CASTS IN THE QUERY WINDOW
+ TFROM,TTO - FIRST AND LAST TIME OF QUERY WINDOW, YYYYMMDDHH
+
+*************************************************************/
+
+struct timeblk {
+ long offset;             /* BYTE OFFSET OF FIRST CAST IN BLOCK */
+ long tmin, tmax;         /* EARLIEST, LATEST TIME, YYYYMMDDHH */
+ long ncast;              /* CASTS IN BLOCK */
+};
+
+int tquery=0;
+long tfrom, tto;
+
+/*************************************************************
+
+ BENCHMARK
+
+ BENCHREP - NUMBER OF TIMES EACH BENCHMARK PASS IS REPEATED (THE
+            FASTEST IS REPORTED), ZERO TO CONVERT NORMALLY
+
+*************************************************************/
+
+int benchrep=0;
+
+/*************************************************************
+
+ VERIFY (-c)
+
+ VERIFYMODE - SET TO ONE TO CHECK EACH FILE'S CASTS AGAINST THEIR
+              BYTE COUNTS INSTEAD OF CONVERTING IT
+
+*************************************************************/
+
+int verifymode=0;
+
+/*************************************************************
+
+ NATIVE FORMAT SUBSET (-w) AND HEADER SELECTION (-id, -cruise)
+
+ SUBSETMODE - SET TO ONE TO COPY EACH CAST SELECTED, AS IT IS, TO A
+              WOD NATIVE FORMAT FILE INSTEAD OF CONVERTING IT
+ COPYFROM, COPYTO - BYTE RANGE OF THE WOD FILE WAITING TO BE COPIED
+                    (CASTS NEXT TO EACH OTHER ARE COPIED TOGETHER)
+ IDLIST, NIDLIST - WOD UNIQUE NUMBERS SELECTED, SORTED
+ CRUISELIST, NCRUISE - CRUISES SELECTED: COUNTRY CODE (EMPTY FOR
+                       ANY) AND CRUISE NUMBER
+
+*************************************************************/
+
+struct cruisesel {
+ char cc[3];
+ int icruise;
+};
+
+int subsetmode=0;
+long copyfrom=0, copyto=0;
+int *idlist=NULL, nidlist=0;
+struct cruisesel *cruiselist=NULL;
+int ncruise=0;
+
+/*************************************************************
+
+ RUN STATISTICS
+
+ STATMODE - SET TO ONE TO TIME EACH STAGE OF THE CONVERSION AND
+            COUNT WHAT WAS READ AND WRITTEN
+ RUNSTAT - TOTALS FOR THIS PROCESS (OR, AFTER A BATCH, FOR ALL
+           WORKERS).  TINPUT IS TIME SPENT READING THE WOD FILE,
+           WHICH IS NOT COUNTED IN THEADER OR TLEVEL.
+ HIST - NUMBER OF CASTS TAKING LESS THAN 1, 2, 4, ... 2**(NBUCKET-1)
+        MICROSECONDS IN EACH STAGE (HEADER DECODE, LEVEL DECODE,
+        FORMAT, WRITE); THE LAST BUCKET HOLDS EVERYTHING SLOWER
+ STATFD - WOD FILE DESCRIPTOR UNDER THE TIMED INPUT STREAM
+ FPFILE - CSV FILE, WHEN FPOUT IS THE IN-MEMORY CAST STREAM
+ REPORTNAME - FILE TO RECEIVE THE RUN REPORT IN JSON, NULL FOR NONE
+
+*************************************************************/
+
+struct runstat {
+ long ncast, nskip;          /* CASTS CONVERTED, SKIPPED */
+ long nbad;                  /* BAD CASTS SKIPPED */
+ long nlevel, nvalue;        /* LEVELS AND DATA VALUES DECODED */
+ long nmissing;              /* DATA VALUES MISSING */
+ long nread, nwrite;         /* BYTES READ AND WRITTEN */
+ double tinput, theader, tlevel, tformat, twrite;
+ long hist[nstage][nbucket];
+ int zsizemax, isizemax;     /* LARGEST DEPTH AND DATA ARRAYS */
+ int ntsetsmax, ntentmax;    /* LARGEST TAXA SETS AND ENTRIES */
+};
+
+int statmode=0, statfd=-1;
+struct runstat runstats;
+FILE *fpfile=NULL;
+char *reportname=NULL;
+
 
 /*************************************************************
 
@@ -226,6 +581,9 @@ float xinterv1,xinterv2;
 
  TENP - POWERS OF TEN
  SDEPTH - STANDARD DEPTH LEVELS
+ ODEPTH - STANDARD DEPTH LEVELS OF THE FORMATS OLDER THAN WOD13
+          ('A' AND 'B'), WHICH DO NOT WRITE OUT THE DEPTHS OF
+          STANDARD LEVEL CASTS
 
 *************************************************************/
 
@@ -247,6 +605,13 @@ float xinterv1,xinterv2;
                   8000, 8100, 8200, 8300, 8400, 8500, 8600, 8700, 8800, 8900,
                   9000 };
 
+ int odepth[] = {  0, 10, 20, 30, 50, 75, 100, 125, 150,
+           200, 250, 300, 400, 500, 600, 700, 800, 900,
+           1000, 1100, 1200, 1300, 1400, 1500, 1750, 2000,
+           2500, 3000, 3500, 4000, 4500, 5000, 5500, 6000,
+           6500, 7000, 7500, 8000, 8500, 9000 };
+ int nodepth= sizeof(odepth) / sizeof(int);
+
  char *namevar[] = { "Temp","Sal","Oxy","Phos","dum5","Sil","dum7",
                      "NO3","pH","dum10","Chl","dum12","dum13","dum14",
                      "dum15","dum16","Alk","dum18","dum19","pCO2",
@@ -255,23 +620,260 @@ float xinterv1,xinterv2;
                      "Trit","He","dHE3","dC14","dC13","Arg","Neo","CFC11",
                      "CFC12","CFC113","O18" };
 
+/*************************************************************
+
+ FUNCTION PROTOTYPES (FOR FUNCTIONS PASSED BY ADDRESS OR NOT
+ RETURNING INT)
+
+*************************************************************/
+
+int bysize(const void *, const void *);
+int byzkey(const void *, const void *);
+int byoffset(const void *, const void *);
+unsigned int zorder(unsigned int, unsigned int);
+unsigned int zcell(int, int);
+unsigned int bigmin(unsigned int, unsigned int, unsigned int);
+long loadindex(char *, char *, void **);
+long boxsearch(struct castidx *, long, int, int, int, int, struct castspan *,
+               long);
+long timesearch(struct timeblk *, long, struct castspan *);
+long selectcasts(char *, struct castspan **);
+long timekey(char *, int);
+long resync(char *, long);
+long nextcast(long);
+double distkm(int, int);
+double seconds();
+FILE *statopen(char *);
+ssize_t statread(void *, char *, size_t);
+int statseek(void *, off64_t *, int);
+int statclose(void *);
+int printAall(int), printAone(int), printSall(int), printSone(int);
+int printBall(int), printBone(int), printIall(int), printIone(int);
+int bypart(const void *, const void *);
+int byint(const void *, const void *);
+char *outext();
+int partnext(FILE *, struct partrec *, char **, int *);
 
 main(int argc, char **argv)
 
 {
 
- char filename[80];
+ char filename[maxname];
  int i=0, j, k, s, jchoice, iend=0;
  int ncast=0,dchoice;
+ int nworkers=1;
+ char *listname=NULL, *mergename=NULL;
+ double tstart= seconds();
+ int showstats=0;
 
- // printf(" Enter input file name\n");
- // scanf("%s",filename);
- strcpy(filename, argv[1]);
+/********************************************************
 
- if ((fp = fopen(filename,"rb+\0")) == NULL)
-  printf("UNABLE TO OPEN FILE\n");
+ READ COMMAND LINE.  WITH A SINGLE INPUT FILE AND NO OPTIONS
+ THE OUTPUT IS WRITTEN TO FILENAME.CSV AS BEFORE.
+
+  -j N     NUMBER OF WORKER PROCESSES FOR BATCH CONVERSION
+  -l LIST  FILE WITH LIST OF WOD FILES TO CONVERT, ONE PER LINE
+  -m FILE  MERGE ALL CONVERTED CASTS INTO A SINGLE CSV FILE
+  -u       CONVERT EACH WOD UNIQUE CAST NUMBER ONLY ONCE, SKIPPING
+           REPEATS IN LATER FILES (OR LATER IN THE SAME FILE)
+  -p KIND  SPLIT OUTPUT INTO NAME.YYYYMM.CSV FILES (KIND month) OR
+           NAME.QLLL.CSV WMO 10 DEGREE SQUARE FILES (KIND square),
+           CASTS IN EACH FILE SORTED BY TIME
+  -M MB    MEGABYTES OF OUTPUT HELD IN MEMORY WHEN PARTITIONING
+  -x       ONLY BUILD THE SPATIAL INDEX (WODFILE.SDX) OF EACH FILE
+  -inv     WRITE AN INVENTORY WODFILE.INV.CSV INSTEAD: ONE ROW PER
+           CAST WITH ITS HEADER, NUMBER OF LEVELS AND VARIABLES, A
+           BIT MASK OF THE VARIABLE CODES (BIT CODE-1) AND ITS BYTE
+           OFFSET, DECODED FROM THE CAST HEADER ONLY
+  -box LAT1 LAT2 LON1 LON2
+           CONVERT ONLY CASTS INSIDE THE BOX (LON1 > LON2 CROSSES
+           THE DATE LINE), FOUND THROUGH THE SPATIAL INDEX
+  -r LAT LON KM
+           CONVERT ONLY CASTS WITHIN KM KILOMETERS OF LAT, LON
+  -t FROM TO
+           CONVERT ONLY CASTS FROM TIME FROM TO TIME TO, EACH GIVEN
+           AS YYYY, YYYYMM, YYYYMMDD OR YYYYMMDDHH, FOUND THROUGH
+           THE TIME INDEX (WODFILE.TDX)
+  -v CODE  CONVERT ONLY VARIABLE CODE (1 TEMPERATURE, 2 SALINITY,
+           ..., 43 OXY18), SKIPPING CASTS WHICH DO NOT HAVE IT
+  -z MODE  WRITE ALL LEVELS (MODE A, THE DEFAULT), ONLY THE SURFACE
+           (S) OR ONLY THE BOTTOM (B) LEVEL OF EACH CAST; ONLY
+           THE LEVELS NEEDED FOR IT ARE DECODED
+  -i ZMIN ZMAX
+           WRITE ONLY LEVELS FROM DEPTH ZMIN TO ZMAX METRES; THE
+           REST OF A CAST BELOW ZMAX IS NOT DECODED
+  -q       WRITE ONLY VALUES FLAGGED 0 (ACCEPTED), AT DEPTHS FLAGGED
+           0, FROM PROFILES FLAGGED 0 (SAME AS -qz 0 -qd 0 -qp 0)
+  -qz FLAGS, -qd FLAGS, -qp FLAGS
+           ACCEPT ONLY THE WOD FLAGS IN THE COMMA SEPARATED LIST
+           (E.G. 0,2) FOR DEPTHS, VALUES OR WHOLE PROFILES
+  -sec CODES
+           ADD A COLUMN FOR EACH SECONDARY HEADER CODE IN THE
+           COMMA SEPARATED LIST (E.G. 29,3), EMPTY WHEN A CAST
+           DOES NOT HAVE IT
+  -psec    ALSO WRITE THE VARIABLE SPECIFIC SECONDARY HEADERS OF
+           EACH CAST CONVERTED (INSTRUMENT, METHOD, ...) TO A SIDE
+           TABLE NAME.PSEC.CSV, ONE ROW PER WOD UNIQUE NUMBER,
+           VARIABLE AND CODE
+  -P N     CONVERT A SINGLE WOD FILE WITH N WORKERS, EACH TAKING
+           ONE BYTE RANGE: A WORKER STARTS AT THE FIRST CAST START
+           IT CAN VALIDATE IN ITS RANGE, AND A RANGE WHOSE START
+           DOES NOT MEET THE END OF THE ONE BEFORE IS CONVERTED
+           AGAIN (NOT WITH -p, -u, -x, -box, -r OR -t)
+  -b N     BENCHMARK EACH FILE INSTEAD OF CONVERTING IT: DECODING
+           ONLY, DECODING AND FORMATTING TO /DEV/NULL, AND FULL
+           CONVERSION, EACH REPEATED N TIMES (-u IS IGNORED)
+  -id FILE CONVERT ONLY THE CASTS WHOSE WOD UNIQUE NUMBERS ARE
+           LISTED IN FILE
+  -cruise LIST
+           CONVERT ONLY CASTS OF THE CRUISES IN THE COMMA SEPARATED
+           LIST, EACH A CRUISE NUMBER WITH OR WITHOUT ITS COUNTRY
+           CODE (E.G. US38379,38378)
+  -w       WRITE THE CASTS SELECTED (BY -box, -r, -t, -v, -id,
+           -cruise, -u OR -qp) TO A WOD NATIVE FORMAT FILE
+           WODFILE.SUB INSTEAD OF CONVERTING THEM.  EACH CAST IS
+           COPIED AS IT IS, WITHOUT DECODING ITS LEVELS.  A
+           DIRECTORY SCAN SKIPS .SUB FILES; NAME ONE TO CONVERT IT
+  -c       CHECK EACH FILE INSTEAD OF CONVERTING IT: EVERY CAST
+           MUST START WITH A FORMAT CODE, HAVE HEADER COUNTS WHICH
+           FIT ITS BYTE COUNT AND END A LINE.  EACH BAD CAST IS
+           REPORTED WITH ITS BYTE OFFSET; THE EXIT STATUS IS ONE IF
+           ANY WAS FOUND
+  -s       REPORT TIME SPENT READING, DECODING, FORMATTING AND
+           WRITING, COUNTS OF CASTS, LEVELS, VALUES AND BYTES, AND
+           HISTOGRAMS OF PER CAST LATENCY OF EACH STAGE
+  -R FILE  WRITE THE SAME STATISTICS, WITH THROUGHPUT AND THE
+           LARGEST ARRAY SIZES NEEDED, TO FILE AS JSON
+
+ ANY OTHER ARGUMENT IS A WOD FILE OR A DIRECTORY OF WOD FILES
 
- else {
+*********************************************************/
+
+ for ( k = 1; k < argc; k++ ) {
+
+  if ( strcmp(argv[k],"-j") == 0 && k+1 < argc ) {
+   nworkers = atoi(argv[++k]);
+   if ( nworkers < 1 ) nworkers=1;
+  }
+  else if ( strcmp(argv[k],"-P") == 0 && k+1 < argc ) {
+   nsplit = atoi(argv[++k]);
+   if ( nsplit < 1 ) nsplit=1;
+  }
+  else if ( strcmp(argv[k],"-l") == 0 && k+1 < argc ) listname= argv[++k];
+  else if ( strcmp(argv[k],"-m") == 0 && k+1 < argc ) mergename= argv[++k];
+  else if ( strcmp(argv[k],"-u") == 0 ) dedup= 1;
+  else if ( strcmp(argv[k],"-p") == 0 && k+1 < argc ) {
+   k++;
+   if ( strcmp(argv[k],"month") == 0 ) partmode= 'M';
+   else if ( strcmp(argv[k],"square") == 0 ) partmode= 'W';
+   else {
+    printf("UNKNOWN PARTITION %s (month OR square)\n",argv[k]);
+    return 1;
+   }
+  }
+  else if ( strcmp(argv[k],"-x") == 0 ) indexonly= 1;
+  else if ( strcmp(argv[k],"-inv") == 0 ) invmode= 1;
+  else if ( strcmp(argv[k],"-box") == 0 && k+4 < argc ) {
+   squery= 1;
+   qlat1= atof(argv[++k]);
+   qlat2= atof(argv[++k]);
+   qlon1= atof(argv[++k]);
+   qlon2= atof(argv[++k]);
+  }
+  else if ( strcmp(argv[k],"-r") == 0 && k+3 < argc ) {
+   squery= 1;
+   qlat0= atof(argv[++k]);
+   qlon0= atof(argv[++k]);
+   qkm= atof(argv[++k]);
+  }
+  else if ( strcmp(argv[k],"-t") == 0 && k+2 < argc ) {
+   tquery= 1;
+   tfrom= timekey(argv[++k],0);
+   tto= timekey(argv[++k],1);
+  }
+  else if ( strcmp(argv[k],"-s") == 0 ) statmode= showstats= 1;
+  else if ( strcmp(argv[k],"-psec") == 0 ) psecout= 1;
+  else if ( strcmp(argv[k],"-z") == 0 && k+1 < argc ) {
+   k++;
+   if ( strcmp(argv[k],"A") == 0 || strcmp(argv[k],"S") == 0 ||
+        strcmp(argv[k],"B") == 0 ) strcpy(xchoice,argv[k]);
+   else {
+    printf("UNKNOWN DEPTH MODE %s (A, S OR B)\n",argv[k]);
+    return 1;
+   }
+  }
+  else if ( strcmp(argv[k],"-i") == 0 && k+2 < argc ) {
+   strcpy(xchoice,"I");
+   xinterv1= atof(argv[++k]);
+   xinterv2= atof(argv[++k]);
+  }
+  else if ( strcmp(argv[k],"-q") == 0 ) qcmode= qcz= qcd= qcp= 1;
+  else if ( strcmp(argv[k],"-qz") == 0 && k+1 < argc ) {
+   if ( (qcz = qcflags(argv[++k])) == -1 ) return 1;
+   qcmode= 1;
+  }
+  else if ( strcmp(argv[k],"-qd") == 0 && k+1 < argc ) {
+   if ( (qcd = qcflags(argv[++k])) == -1 ) return 1;
+   qcmode= 1;
+  }
+  else if ( strcmp(argv[k],"-qp") == 0 && k+1 < argc ) {
+   if ( (qcp = qcflags(argv[++k])) == -1 ) return 1;
+   qcmode= 1;
+  }
+  else if ( strcmp(argv[k],"-v") == 0 && k+1 < argc ) {
+   vchoice= atoi(argv[++k]);
+   if ( vchoice < 1 || vchoice > nvars ) {
+    printf("UNKNOWN VARIABLE %s (1 TO %d)\n",argv[k],nvars);
+    return 1;
+   }
+  }
+  else if ( strcmp(argv[k],"-sec") == 0 && k+1 < argc ) {
+   if ( addseccols(argv[++k]) != 0 ) return 1;
+  }
+  else if ( strcmp(argv[k],"-R") == 0 && k+1 < argc ) {
+   statmode= 1;
+   reportname= argv[++k];
+  }
+  else if ( strcmp(argv[k],"-b") == 0 && k+1 < argc ) {
+   benchrep = atoi(argv[++k]);
+   if ( benchrep < 1 ) benchrep=1;
+  }
+  else if ( strcmp(argv[k],"-c") == 0 ) verifymode= 1;
+  else if ( strcmp(argv[k],"-w") == 0 ) subsetmode= 1;
+  else if ( strcmp(argv[k],"-id") == 0 && k+1 < argc ) {
+   if ( idload(argv[++k]) != 0 ) return 1;
+  }
+  else if ( strcmp(argv[k],"-cruise") == 0 && k+1 < argc ) {
+   if ( cruiseload(argv[++k]) != 0 ) return 1;
+  }
+  else if ( strcmp(argv[k],"-M") == 0 && k+1 < argc ) {
+   partmem= atol(argv[++k]) * 1024L * 1024L;
+   if ( partmem <= 0 ) partmem= 1024L * 1024L;
+  }
+  else if ( *argv[k] == '-' ) {
+   printf("UNKNOWN OPTION %s\n",argv[k]);
+   return 1;
+  }
+  else addinput(argv[k]);
+
+ }
+
+ if ( listname != NULL ) addlist(listname);
+ if ( ninputfail > 0 ) {
+  printf(" %d INPUT FILES COULD NOT BE READ\n",ninputfail);
+  iend= 1;
+ }
+
+ if ( ninput == 0 ) {
+  printf("USAGE: %s [-j N] [-l LIST] [-m MERGED.CSV] [-u]\n",argv[0]);
+  printf("        [-p month|square] [-M MB] [-x] [-inv] [-box LAT1 LAT2 LON1 LON2]\n");
+  printf("        [-r LAT LON KM] [-t FROM TO] [-v CODE]\n");
+  printf("        [-z A|S|B] [-i ZMIN ZMAX] [-q] [-qz FLAGS] [-qd FLAGS] [-qp FLAGS]\n");
+  printf("        [-sec CODES] [-psec] [-id FILE] [-cruise LIST] [-w]\n");
+  printf("        [-P N] [-b N] [-c] [-s] [-R REPORT.JSON]\n");
+  printf("        WODFILE|DIR ...\n");
+  return 1;
+ }
 
   // printf( "Which variable would you like to see:\n");
   // printf( " 0 - All\n");
@@ -298,7 +900,7 @@ main(int argc, char **argv)
   // printf( "42 - CFC113\n");
   // printf( "43 - Oxy18\n");
   // scanf("%d",&jchoice);
-  jchoice = 0;
+  jchoice = vchoice;
 
   // printf( "Which depths would you like output:\n");
   // printf( " A - All\n");
@@ -306,14 +908,7 @@ main(int argc, char **argv)
   // printf( " B - Bottom [Deepest measurement only]\n");
   // printf( " I - Interval [measurements only between min/max depth]\n");
   // scanf("%s",xchoice); 
-  strcpy(xchoice, "A");
-
-  if ( *xchoice == 'I' ) {
-   printf("Enter shallowest depth\n");
-   scanf("%f",&xinterv1);
-   printf("Enter deepest depth\n");
-   scanf("%f",&xinterv2);
-  }
+  pickkernel(*xchoice,jchoice);
 
 /********************************************************
 
@@ -323,15 +918,10 @@ main(int argc, char **argv)
 
   spacer(1);
 
-/*   GET USER INFORMATION (NUMBER OF CASTS, OUTPUT FILE NAME) */
-
-  // printf(" Enter output file name\n");
-  // scanf("%s",filename);
-  strcat(filename,".csv");
+  if ( benchrep > 0 ) dedup= 0;
+  if ( dedup == 1 && seeninit() != 0 ) return 1;
 
-  if ((fpout = fopen(filename,"w\0")) == NULL) {
-   printf("UNABLE TO OPEN FILE\n");
-  }
+/*   GET USER INFORMATION (NUMBER OF CASTS, OUTPUT FILE NAME) */
 
   // printf(" ENTER NUMBER OF CASTS TO VIEW");
   // printf (" (0 FOR ALL CASTS IN FILE)\n");
@@ -340,107 +930,3549 @@ main(int argc, char **argv)
 
   if ( ncast == 0 ) ncast=100000000;
 
-  printheader(jchoice);
+/********************************************************
 
-  while ( !feof(fp) && iend != -1 && (i++) < ncast ) {
+ BENCHMARK: EACH FILE IN TURN, IN THIS PROCESS
+
+*********************************************************/
+
+ if ( benchrep > 0 ) {
+
+  for ( k = 0; k < ninput; k++ )
+   benchfile(*(inputs+k),*(inputsize+k),ncast,jchoice);
+  return iend;
+
+ }
 
 /********************************************************
 
- READ IN CAST
+ VERIFY: EACH FILE IN TURN, IN THIS PROCESS
 
-**********************************************************/
+*********************************************************/
+
+ if ( verifymode == 1 ) {
+
+  for ( k = 0; k < ninput; k++ )
+   if ( verifyfile(*(inputs+k)) != 0 ) iend= 1;
+  return iend;
+
+ }
+
+/********************************************************
+
+ SINGLE FILE SPLIT INTO BYTE RANGES, OUTPUT TO FILENAME.CSV (OR
+ THE MERGED FILE)
+
+*********************************************************/
+
+ if ( subsetmode == 1 && partmode != 0 ) {
+  printf(" -p IS NOT USED WITH -w\n");
+  partmode= 0;
+ }
 
-   if ( ( iend = oclread() ) == -1 ) printf(" END OF FILE REACHED\n");
+ if ( nsplit > 1 && ( partmode != 0 || dedup == 1 || indexonly == 1 ||
+                      squery == 1 || tquery == 1 ) ) {
+  printf(" -P IS NOT USED WITH -p, -u, -x, -box, -r OR -t\n");
+  nsplit= 1;
+ }
 
-   else printstation(i,jchoice);
+ if ( ninput == 1 && nsplit > 1 ) {
 
+  if ( mergename == NULL ) {
+   strcpy(filename, *inputs);
+   strcat(filename,outext());
   }
+  else snprintf(filename,maxname,"%s",mergename);
+
+  nworkers= nsplit;
+  if ( splitfile(*inputs,*inputsize,filename,jchoice) != 0 ) iend= 1;
+
+ }
+
+/********************************************************
+
+ SINGLE FILE: CONVERT IN THIS PROCESS, OUTPUT TO FILENAME.CSV
+
+*********************************************************/
+
+ else if ( ninput == 1 && mergename == NULL ) {
+
+  // printf(" Enter output file name\n");
+  // scanf("%s",filename);
+  strcpy(filename, *inputs);
+  strcat(filename,outext());
+
+  convertfile(*inputs,filename,ncast,jchoice);
+
+ }
 
-  i = fclose(fp); 
-  i = fclose(fpout); 
-  printf("iii %d\n",i);
+ else if ( batch(nworkers,mergename,ncast,jchoice) != 0 ) iend= 1;
 
+ if ( statmode == 1 ) {
+  statpeak(&runstats);
+  if ( showstats == 1 ) statreport(seconds() - tstart);
+  if ( reportname != NULL &&
+       statjson(reportname,seconds() - tstart,nworkers,iend) != 0 &&
+       iend == 0 ) iend= 1;
  }
 
+ return iend;
+
 }
-oclread()
+
+/***************************************************************
+
+              FUNCTION CONVERTFILE
+
+ CONVERTFILE CONVERTS ONE WOD FILE TO ONE CSV FILE.  RETURNS
+ ZERO, OR -1 IF A FILE COULD NOT BE OPENED OR WRITTEN.
+
+***************************************************************/
+
+convertfile(char *infile, char *outfile, int ncast, int jchoice)
 
 {
 
- int i,j;
+ int i=0, iend=0;
+ struct castspan *sel=NULL;
+ struct stat st;
+ long nsel=0, isel=0, nleft=0;
+ double t0=0., t1=0.;
 
- char wodform;
- int totfig=0, sigfig=0, rightfig=0;
- int nbytet,ntypec,nbytec,nbytes,nbyteb;
- int ninfc,ntoff, doff;
- int missing=-9999;
- int npinfs=0,npinfe=0,npinf;
- int iend=0;
+ if ( indexonly == 1 ) return buildindex(infile);
+ hdronly= ( invmode == 1 || subsetmode == 1 ) ? 2 : 0;
 
-/**********************************************************
+ filesize= ( stat(infile,&st) == 0 ) ? st.st_size : 0;
 
- READ IN WOD FORMAT CODE: 'C' FOR WOD13 FORMAT
- 'B' FOR WOD05/WOD09 FORMAT
- 'A' FOR WOD01 FORMAT
+ if ( ( squery == 1 || tquery == 1 ) &&
+      (nsel = selectcasts(infile,&sel)) < 0 ) return -1;
 
-***********************************************************/
+ fp= ( statmode == 1 ) ? statopen(infile) : fopen(infile,"rb\0");
+ if ( fp == NULL ) {
+  printf("UNABLE TO OPEN FILE %s\n",infile);
+  return -1;
+ }
 
- totfig= 1;
- if ( (iend = extractc(0,&totfig,&wodform)) == -1 ) return iend;
+ if ( partmode != 0 ) {
+
+/********************************************************
+
+ PARTITIONED OUTPUT: EACH CAST IS FORMATTED INTO MEMORY AND
+ FILED UNDER ITS PARTITION.  WHEN NOT MERGING, THIS FILE'S
+ PARTITIONS ARE WRITTEN WHEN THE FILE IS DONE.
+
+*********************************************************/
+
+  if ( partcast() != 0 ) {
+   fclose(fp);
+   return -1;
+  }
+  if ( noheader == 0 ) partbase(runbase,outfile);
+
+ }
 
- if ( wodform != 'C' ) {
-  printf("file is not in WOD13 format\n");
-  printf("csvfromwod cannot translate data\n");
+ else if ((fpout = fopen(outfile,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",outfile);
+  fclose(fp);
   return -1;
  }
 
-/**********************************************************
+ if ( noheader == 0 && partmode == 0 ) printheader(jchoice);
 
- READ IN NUMBER OF BYTES IN ASCII CAST 
+ if ( rangefrom > 0 ) fseek(fp,rangefrom,SEEK_SET);
 
-***********************************************************/
+ if ( psecout == 1 && psecopen(outfile) != 0 ) {
+  fclose(fp);
+  if ( partmode == 0 ) fclose(fpout);
+  return -1;
+ }
 
- if ( ( iend = extracti(0,&totfig,&sigfig,&rightfig,&nbytet,missing))
-          == -1 ) return iend;
+/********************************************************
 
-/**********************************************************
+ TIMED RUN: EACH CAST IS FORMATTED INTO MEMORY, THEN WRITTEN,
+ SO FORMATTING AND WRITING ARE TIMED SEPARATELY
 
- READ IN WOD CAST NUMBER
+*********************************************************/
 
-***********************************************************/
+ fpfile= NULL;
+ if ( statmode == 1 && partmode == 0 ) {
+  fpfile= fpout;
+  if ( partcast() != 0 ) {
+   fclose(fp);
+   fclose(fpfile);
+   return -1;
+  }
+ }
 
- if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&ostation,missing))
-       == -1 ) return iend;
+ while ( !feof(fp) && iend != -1 && (i++) < ncast ) {
 
-/*********************************************************
+/********************************************************
 
- READ IN NODC COUNTRY CODE
+ WITH AN INDEX QUERY, GO STRAIGHT TO THE NEXT SELECTED CASTS
 
 **********************************************************/
 
- totfig= 2;
- if ( (iend = extractc(0,&totfig,cc)) == -1 ) return iend;
+  if ( rangeto > 0 && ftell(fp) >= rangeto ) break;
 
-/**********************************************************
+  if ( sel != NULL ) {
+   if ( nleft == 0 ) {
+    if ( isel >= nsel ) break;
+    fseek(fp,(sel+isel)->offset,SEEK_SET);
+    nleft= (sel+isel++)->ncast;
+   }
+   nleft--;
+  }
 
- READ IN CRUISE NUMBER
+/********************************************************
 
-***********************************************************/
+ READ IN CAST
 
- if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&icruise,
-             missing)) == -1) return iend;
+**********************************************************/
 
-/**********************************************************
+  if ( ( iend = oclread() ) == -1 ) {
+   if ( castbytes > 0 ) badcast("CUT SHORT BY THE END OF THE FILE");
+   printf(" END OF FILE REACHED\n");
+  }
 
- READ IN YEAR, MONTH, DAY, TIME
+  else if ( iend == 0 && dedup == 1 && seenmark(ostation) ) {
+   nduplicate++;
+   runstats.nskip++;
+  }
 
-***********************************************************/
+  else if ( iend == 0 ) {
+   if ( statmode == 1 ) t0= seconds();
+   printstation(i,jchoice);
+   if ( fppsec != NULL ) printpsec(jchoice);
+   if ( statmode == 1 ) t1= seconds();
+   if ( partmode != 0 && partadd() != 0 ) iend= -1;
+   if ( fpfile != NULL && statwrite() != 0 ) iend= -1;
+   if ( statmode == 1 ) {
+    statadd(2,t1-t0);
+    statadd(3,seconds()-t1);
+    runstats.ncast++;
+   }
+  }
 
- totfig=4;
- if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&year,missing))
-       == -1) return iend;
- totfig=2;
- if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&month,missing))
+  else if ( iend == 1 ) runstats.nskip++;
+
+ }
+
+ if ( nduplicate > 0 ) {
+  printf(" %d DUPLICATE CASTS SKIPPED IN %s\n",nduplicate,infile);
+  nduplicate= 0;
+ }
+
+ if ( nbadcast > 0 ) {
+  printf(" %d BAD CASTS SKIPPED IN %s\n",nbadcast,infile);
+  nbadcast= 0;
+ }
+
+ if ( subsetmode == 1 && copyflush() != 0 ) iend= -1;
+
+ rangestop= ftell(fp);
+ fclose(fp); 
+ free(sel);
+ if ( fppsec != NULL && fclose(fppsec) != 0 ) iend= -1;
+ fppsec= NULL;
+
+ if ( partmode != 0 ) {
+  i= 0;
+  t0= seconds();
+  if ( noheader == 0 ) i= partfinish(runbase,jchoice);
+  if ( statmode == 1 ) runstats.twrite += seconds() - t0;
+  return i;
+ }
+
+ if ( fpfile != NULL ) {
+  fpout= fpfile;
+  fpfile= NULL;
+ }
+ i = fclose(fpout); 
+ printf("iii %d\n",i);
+
+ return ( i == 0 ) ? 0 : -1;
+
+}
+
+/***************************************************************
+
+              FUNCTION SPLITFILE
+
+ SPLITFILE CONVERTS ONE WOD FILE OF FSIZE BYTES TO OUTFILE WITH
+ NSPLIT WORKERS, EACH TAKING AN EQUAL BYTE RANGE OF THE FILE
+ WITHOUT AN INDEX.  EACH WORKER STARTS AT THE FIRST CAST START IT
+ CAN VALIDATE IN ITS RANGE (SEE RESYNC) AND CONVERTS THE CASTS
+ STARTING IN THE RANGE INTO A PART FILE.  THE PARTS ARE THEN
+ STITCHED TOGETHER IN ORDER: A RANGE WHICH DOES NOT START WHERE THE
+ ONE BEFORE IT STOPPED (A FALSE CAST START WAS TAKEN) IS CONVERTED
+ AGAIN FROM THAT POINT.  RETURNS ZERO, OR ONE ON FAILURE.
+
+***************************************************************/
+
+splitfile(char *infile, long fsize, char *outfile, int jchoice)
+
+{
+
+ struct splitrange *rng;
+ struct runstat *slot=NULL;
+ char partfile[maxname], name[maxname];
+ int *redo, k, nfail=0, status;
+ FILE *fpside=NULL;
+ pid_t pid;
+
+ if ( fsize / nsplit < splitmin ) nsplit= fsize / splitmin;
+ if ( nsplit < 2 ) return ( convertfile(infile,outfile,100000000,jchoice)
+                            != 0 );
+
+ if ( (rng = mmap(NULL,nsplit * sizeof(struct splitrange),
+             PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0))
+      == MAP_FAILED || (redo = calloc(nsplit,sizeof(int))) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %d RANGES\n",nsplit);
+  return 1;
+ }
+
+ if ( statmode == 1 &&
+      (slot = mmap(NULL,nsplit * sizeof(struct runstat),
+              PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0))
+      == MAP_FAILED ) slot= NULL;
+
+ noheader= 1;
+
+ for ( k = 0; k < nsplit; k++ ) {
+
+  (rng+k)->start= fsize / nsplit * k;
+  (rng+k)->end= ( k == nsplit - 1 ) ? fsize : fsize / nsplit * (k+1);
+  (rng+k)->first= (rng+k)->stop= -1;
+
+  if ( (pid = fork()) == -1 ) {
+   printf(" UNABLE TO START WORKER %d\n",k);
+   continue;
+  }
+
+  if ( pid == 0 ) {
+
+/***************************************************************
+
+ WORKER: FIND THE FIRST CAST START, CONVERT THE RANGE
+
+****************************************************************/
+
+   snprintf(partfile,maxname,"%s.r%d",outfile,k);
+   rangefrom= ( k == 0 ) ? 0 : resync(infile,(rng+k)->start);
+   rangeto= (rng+k)->end;
+   if ( rangefrom < 0 ||
+        convertfile(infile,partfile,100000000,jchoice) != 0 ) exit(1);
+   (rng+k)->first= rangefrom;
+   (rng+k)->stop= rangestop;
+   if ( slot != NULL ) {
+    statpeak(&runstats);
+    memcpy(slot+k,&runstats,sizeof(struct runstat));
+   }
+   exit(0);
+
+  }
+
+ }
+
+ while ( wait(&status) > 0 ) {
+  if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) nfail++;
+ }
+
+/***************************************************************
+
+ STITCH: CONVERT AGAIN, HERE, EACH RANGE WHICH DOES NOT JOIN UP
+ WITH THE ONE BEFORE IT (OR WHOSE WORKER FAILED)
+
+****************************************************************/
+
+ for ( k = 0; k < nsplit; k++ ) {
+
+  rangefrom= ( k == 0 ) ? 0 : (rng+k-1)->stop;
+  if ( (rng+k)->first == rangefrom && (rng+k)->stop >= 0 ) continue;
+
+  if ( rangefrom < 0 ) {
+   nfail++;
+   break;
+  }
+  if ( k > 0 ) printf(" RANGE %d OF %s STARTED AT %ld, NOT AT %ld: CONVERTING IT AGAIN\n",
+                      k,infile,(rng+k)->first,rangefrom);
+
+  snprintf(partfile,maxname,"%s.r%d",outfile,k);
+  rangeto= (rng+k)->end;
+  (rng+k)->stop= -1;
+  if ( convertfile(infile,partfile,100000000,jchoice) == 0 )
+   (rng+k)->stop= rangestop;
+  *(redo+k)= 1;
+
+ }
+
+ rangefrom= rangeto= 0;
+ noheader= 0;
+
+ if ( slot != NULL ) {
+  for ( k = 0; k < nsplit; k++ ) if ( *(redo+k) == 0 ) statsum(slot+k);
+  munmap(slot,nsplit * sizeof(struct runstat));
+ }
+
+/***************************************************************
+
+ JOIN THE PARTS, IN ORDER, UNDER ONE COLUMN HEADER
+
+****************************************************************/
+
+ if ((fpout = fopen(outfile,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",outfile);
+  return 1;
+ }
+ printheader(jchoice);
+
+ if ( psecout == 1 ) {
+  psecname(name,outfile);
+  if ((fpside = fopen(name,"w\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",name);
+   nfail++;
+  }
+  else fprintf(fpside,"%s\n",psechead);
+ }
+
+ for ( k = 0; k < nsplit; k++ ) {
+  snprintf(partfile,maxname,"%s.r%d",outfile,k);
+  nfail += catpart(fpout,partfile);
+  if ( fpside != NULL ) {
+   psecname(name,partfile);
+   nfail += catpart(fpside,name);
+  }
+ }
+
+ if ( fclose(fpout) != 0 ) nfail++;
+ if ( fpside != NULL && fclose(fpside) != 0 ) nfail++;
+
+ munmap(rng,nsplit * sizeof(struct splitrange));
+ free(redo);
+ if ( nfail > 0 ) printf(" %d RANGES OF %s FAILED\n",nfail,infile);
+ return ( nfail > 0 );
+
+}
+
+/***************************************************************
+
+              FUNCTION RESYNC
+
+ RESYNC RETURNS THE BYTE OFFSET OF THE FIRST CAST START AT OR
+ AFTER BYTE FROM OF WOD FILE INFILE (THE END OF THE FILE IF THERE
+ IS NONE), OR -1 IF THE FILE CANNOT BE READ.  A CAST START IS A
+ LINE STARTING WITH A FORMAT CODE AND A BYTE COUNT, WHERE THE CAST
+ OF THAT MANY BYTES ENDS A LINE AND IS FOLLOWED BY THE END OF THE
+ FILE OR BY ANOTHER LINE STARTING WITH A FORMAT CODE.
+
+***************************************************************/
+
+long resync(char *infile, long from)
+
+{
+
+ long pos;
+
+ if ( (fp = fopen(infile,"rb\0")) == NULL ) {
+  printf("UNABLE TO OPEN FILE %s\n",infile);
+  return -1;
+ }
+
+ pos= nextcast(from);
+ fclose(fp);
+ return pos;
+
+}
+
+/***************************************************************
+
+              FUNCTION NEXTCAST
+
+ NEXTCAST MOVES THE WOD FILE TO THE FIRST CAST START AT OR AFTER
+ BYTE FROM (FROM > 0), AS DESCRIBED FOR RESYNC, AND RETURNS ITS
+ OFFSET.  IF THERE IS NONE, IT RETURNS THE OFFSET OF THE END OF
+ THE FILE, WITH THE FILE AT ITS END.
+
+***************************************************************/
+
+long nextcast(long from)
+
+{
+
+ long pos;
+ int i;
+
+/***************************************************************
+
+ GO TO THE FIRST LINE STARTING AT OR AFTER FROM
+
+****************************************************************/
+
+ fseek(fp,from-1,SEEK_SET);
+ while ( ( i = fgetc(fp)) != '\n' && i != EOF );
+
+ while ( 1 ) {
+
+  pos= ftell(fp);
+  if ( (i = fgetc(fp)) == EOF ) return pos;
+
+  if ( ( i == 'C' || i == 'B' || i == 'A' ) && castcheck() == 0 ) {
+   fseek(fp,pos,SEEK_SET);
+   return pos;
+  }
+
+  fseek(fp,pos+1,SEEK_SET);
+  while ( ( i = fgetc(fp)) != '\n' && i != EOF );
+
+ }
+
+}
+
+/***************************************************************
+
+              FUNCTION BADCAST
+
+ BADCAST REPORTS THE PRESENT CAST AS BAD, WITH ITS BYTE OFFSET,
+ WOD UNIQUE NUMBER (IF READ) AND WHY, COUNTS IT, AND MOVES THE WOD
+ FILE TO THE NEXT CAST START FOUND AFTER IT.
+
+ RETURNS 2 (CAST SKIPPED AS BAD) OR -1 IF NO CAST IS LEFT
+
+***************************************************************/
+
+badcast(char *why)
+
+{
+
+ if ( ostation > 0 )
+  printf(" BAD CAST AT BYTE %ld (WOD UNIQUE %d): %s\n",castoffset,
+         ostation,why);
+ else printf(" BAD CAST AT BYTE %ld: %s\n",castoffset,why);
+
+ nbadcast++;
+ runstats.nbad++;
+
+ nextcast(castoffset+1);
+ castbytes= 0;
+ return ( feof(fp) ) ? -1 : 2;
+
+}
+
+/***************************************************************
+
+              FUNCTION CASTCHECK
+
+ CASTCHECK CHECKS THAT THE TEXT AFTER A FORMAT CODE IS A VALID
+ BYTE COUNT FOR A CAST ENDING A LINE, FOLLOWED BY THE END OF THE
+ FILE OR BY A LINE STARTING WITH A FORMAT CODE.  RETURNS ZERO IF
+ IT IS.
+
+***************************************************************/
+
+castcheck()
+
+{
+
+ int i, j, n, nbytet=0;
+
+ castbytes= 1;
+ n= nocrfgetc() - '0';
+ if ( n < 1 || n > 9 ) return -1;
+
+ for ( j = 0; j < n; j++ ) {
+  if ( !isdigit(i = nocrfgetc()) ) return -1;
+  nbytet= 10 * nbytet + ( i - '0' );
+ }
+
+ if ( nbytet <= castbytes || skipcast(nbytet) == -1 ) return -1;
+
+ i= fgetc(fp);
+ return ( i == EOF || i == 'C' || i == 'B' || i == 'A' ) ? 0 : -1;
+
+}
+
+/***************************************************************
+
+              FUNCTION CATPART
+
+ CATPART APPENDS PART FILE NAME TO FILE FPTO AND REMOVES IT.
+ RETURNS ONE IF THE PART IS MISSING.
+
+***************************************************************/
+
+catpart(FILE *fpto, char *name)
+
+{
+
+ char buf[65536];
+ FILE *fppart;
+ size_t n;
+
+ if ((fppart = fopen(name,"rb\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",name);
+  return 1;
+ }
+
+ while ( (n = fread(buf,1,sizeof(buf),fppart)) > 0 )
+  fwrite(buf,1,n,fpto);
+
+ fclose(fppart);
+ remove(name);
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION BENCHFILE
+
+ BENCHFILE TIMES THE CONVERSION OF ONE WOD FILE IN THREE PASSES,
+ EACH REPEATED BENCHREP TIMES WITH THE FASTEST KEPT:
+
+  DECODE   - OCLREAD ONLY
+  FORMAT   - OCLREAD AND PRINTSTATION TO /DEV/NULL, WITH THE
+             TIME SPENT IN PRINTSTATION REPORTED SEPARATELY
+  CONVERT  - CONVERTFILE, WRITING FILENAME.CSV AS USUAL
+
+ RATES ARE MEGABYTES OF WOD INPUT AND CASTS PER SECOND.
+
+***************************************************************/
+
+benchfile(char *infile, long fsize, int ncast, int jchoice)
+
+{
+
+ char outfile[maxname];
+ int i, j, iend, nc=0;
+ double t0, t1, tprint, best[4];
+ double mb;
+ static char *stage[] = { "DECODE", "FORMAT", "  (PRINTSTATION)",
+                          "CONVERT" };
+
+ for ( j = 0; j < 4; j++ ) *(best+j)= 1.e30;
+ filesize= fsize;
+
+ for ( j = 0; j < benchrep; j++ ) {
+
+/********************************************************
+
+ DECODE ONLY
+
+*********************************************************/
+
+  if ((fp = fopen(infile,"rb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",infile);
+   return -1;
+  }
+
+  i= 0;
+  nc= 0;
+  iend= 0;
+  t0= seconds();
+  while ( !feof(fp) && iend != -1 && (i++) < ncast )
+   if ( (iend = oclread()) == 0 ) nc++;
+  t1= seconds() - t0;
+  if ( t1 < *best ) *best= t1;
+  fclose(fp);
+
+/********************************************************
+
+ DECODE AND FORMAT, OUTPUT DISCARDED
+
+*********************************************************/
+
+  if ((fp = fopen(infile,"rb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",infile);
+   return -1;
+  }
+  if ((fpout = fopen("/dev/null","w\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE /dev/null\n");
+   fclose(fp);
+   return -1;
+  }
+
+  i= 0;
+  iend= 0;
+  tprint= 0.;
+  t0= seconds();
+  printheader(jchoice);
+  while ( !feof(fp) && iend != -1 && (i++) < ncast ) {
+   if ( (iend = oclread()) == 0 ) {
+    t1= seconds();
+    printstation(i,jchoice);
+    tprint += seconds() - t1;
+   }
+  }
+  t1= seconds() - t0;
+  if ( t1 < *(best+1) ) *(best+1)= t1;
+  if ( tprint < *(best+2) ) *(best+2)= tprint;
+  fclose(fp);
+  fclose(fpout);
+
+/********************************************************
+
+ FULL CONVERSION
+
+*********************************************************/
+
+  snprintf(outfile,maxname,"%s.csv",infile);
+  t0= seconds();
+  if ( convertfile(infile,outfile,ncast,jchoice) != 0 ) return -1;
+  t1= seconds() - t0;
+  if ( t1 < *(best+3) ) *(best+3)= t1;
+
+ }
+
+ mb= (double) fsize / ( 1024. * 1024. );
+
+ printf("\n BENCHMARK %s: %.2f MB, %d CASTS, BEST OF %d\n",
+        infile,mb,nc,benchrep);
+ for ( j = 0; j < 4; j++ ) {
+  t1= ( *(best+j) > 0. ) ? *(best+j) : 1.e-9;
+  printf(" %-17s %10.4f S %10.2f MB/S %12.1f CASTS/S\n",
+         *(stage+j),*(best+j),mb/t1,nc/t1);
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION VERIFYFILE
+
+ VERIFYFILE CHECKS EVERY CAST OF WOD FILE INFILE WITHOUT DECODING
+ ITS LEVELS (SEE VERIFYCAST), REPORTS EACH BAD CAST AND CARRIES ON
+ FROM THE NEXT CAST START FOUND.  RETURNS ZERO IF ALL CASTS ARE
+ GOOD, ONE IF ANY IS BAD, OR -1 IF THE FILE CANNOT BE READ.
+
+***************************************************************/
+
+verifyfile(char *infile)
+
+{
+
+ struct stat st;
+ long ngood=0;
+ int iend=0, nbad= nbadcast;
+ double t0, t1, mb;
+
+ if ( stat(infile,&st) != 0 || (fp = fopen(infile,"rb\0")) == NULL ) {
+  printf("UNABLE TO OPEN FILE %s\n",infile);
+  return -1;
+ }
+
+ filesize= st.st_size;
+ t0= seconds();
+
+ while ( !feof(fp) ) {
+
+  if ( ( iend = verifycast() ) == -1 ) {
+   if ( castbytes > 0 ) badcast("CUT SHORT BY THE END OF THE FILE");
+   break;
+  }
+  if ( iend == 0 ) ngood++;
+  else if ( !feof(fp) )
+   printf("  NEXT CAST START FOUND AT BYTE %ld\n",ftell(fp));
+
+ }
+
+ t1= seconds() - t0;
+ fclose(fp);
+
+ nbad= nbadcast - nbad;
+ mb= (double) filesize / ( 1024. * 1024. );
+ printf(" %s: %ld CASTS, %d BAD, %.2f MB AT %.2f MB/S\n",infile,
+        ngood,nbad,mb,mb / ( ( t1 > 0. ) ? t1 : 1.e-9 ));
+
+ return ( nbad > 0 );
+
+}
+
+/***************************************************************
+
+              FUNCTION VERIFYCAST
+
+ VERIFYCAST CHECKS THE NEXT CAST OF THE WOD FILE: IT MUST START A
+ LINE WITH A FORMAT CODE, ITS BYTE COUNT MUST BE SENSIBLE AND FIT
+ IN THE FILE, THE BYTE COUNTS OF ITS CHARACTER, SECONDARY HEADER
+ AND BIOLOGY BLOCKS MUST FIT IN IT, AND THE BYTES LEFT FOR ITS
+ LEVELS MUST FIT THE NUMBER OF LEVELS AND VARIABLES (EACH VALUE
+ TAKES ONE TO FOURTEEN BYTES, A DEPTH SIX TO FOURTEEN).  ONLY THE
+ HEADER IS DECODED; THE LEVELS ARE READ PAST A LINE AT A TIME
+ (SKIPREST), AND THE CAST MUST END A LINE.
+
+ RETURNS 0 (GOOD CAST), 2 (BAD CAST, SEE BADCAST) OR -1 FOR END
+ OF FILE
+
+***************************************************************/
+
+verifycast()
+
+{
+
+ int totfig, sigfig, rightfig, iend, i, j, form;
+ int nbytet, levels, isoor, nparm, npinf, nblock, code;
+ int htotfig, hsigfig, hrightfig, missing=-9999;
+ char cc[3];
+ long rest, lmin, lmax;
+
+ castoffset= ftell(fp);
+ castbytes= 0;
+ ostation= 0;
+
+ if ( (form = fgetc(fp)) == EOF ) return -1;
+ castbytes++;
+ if ( form != 'C' && form != 'B' && form != 'A' )
+  return badcast("NO WOD01, WOD05, WOD09 OR WOD13 FORMAT CODE");
+
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nbytet,missing))
+      == -1 ) return iend;
+ if ( totfig < 1 || nbytet < 20 )
+  return badcast("BYTE COUNT MISSING OR TOO SMALL");
+ if ( castoffset + nbytet > filesize )
+  return badcast("BYTE COUNT RUNS PAST THE END OF THE FILE");
+
+/**********************************************************
+
+ READ PAST THE CAST NUMBER, COUNTRY, CRUISE, DATE, TIME AND
+ POSITION
+
+***********************************************************/
+
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&ostation,missing))
+      == -1 ) return iend;
+ totfig= 2;
+ if ( (iend = extractc(0,&totfig,cc)) == -1 ) return iend;
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&code,missing))
+      == -1 ) return iend;
+ totfig= 8;
+ if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&code,missing))
+      == -1 ) return iend;
+ for ( j = 0; j < 3; j++ )
+  if ( (iend = extracti(1,&htotfig,&hsigfig,&hrightfig,&code,missing))
+       == -1 ) return iend;
+
+/**********************************************************
+
+ NUMBER OF LEVELS, LEVEL TYPE AND VARIABLES
+
+***********************************************************/
+
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&levels,missing))
+      == -1 ) return iend;
+ totfig= 1;
+ if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&isoor,missing))
+      == -1 ) return iend;
+ totfig= 2;
+ if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&nparm,missing))
+      == -1 ) return iend;
+ if ( levels < 0 || ( isoor != 0 && isoor != 1 ) || nparm < 0 )
+  return badcast("BAD LEVEL OR VARIABLE COUNT");
+
+ for ( i = 0; i < nparm; i++ ) {
+
+  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&code,missing))
+       == -1 ) return iend;
+  totfig= 1;
+  if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&code,missing))
+       == -1 ) return iend;
+  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&npinf,missing))
+       == -1 ) return iend;
+  if ( npinf < 0 || npinf > nbytet )
+   return badcast("TOO MANY VARIABLE SPECIFIC SECOND HEADERS");
+
+  for ( j = 0; j < npinf; j++ ) {
+   if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&code,missing))
+        == -1 ) return iend;
+   if ( (iend = extracti(1,&htotfig,&hsigfig,&hrightfig,&code,
+                missing)) == -1 ) return iend;
+  }
+
+  if ( castbytes > nbytet )
+   return badcast("HEADER LONGER THAN BYTE COUNT");
+
+ }
+
+/**********************************************************
+
+ CHARACTER DATA, SECONDARY HEADER AND BIOLOGY BLOCKS, EACH
+ SKIPPED USING ITS BYTE COUNT
+
+***********************************************************/
+
+ for ( j = 0; j < 3; j++ ) {
+
+  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nblock,missing))
+       == -1 ) return iend;
+  if ( nblock < 0 || castbytes + nblock > nbytet )
+   return badcast("BLOCK BYTE COUNT LARGER THAN CAST");
+  if ( nblock > 0 && (iend = skipbytes(nblock)) == -1 ) return iend;
+
+ }
+
+/**********************************************************
+
+ THE BYTES LEFT MUST HOLD THE LEVELS
+
+***********************************************************/
+
+ rest= nbytet - castbytes;
+ lmin= (long) levels * nparm;
+ lmax= (long) levels * nparm * 14;
+ if ( isoor == 0 || form == 'C' ) {
+  lmin += 6L * levels;
+  lmax += 14L * levels;
+ }
+ if ( rest < lmin || rest > lmax )
+  return badcast("LEVEL COUNTS DO NOT FIT BYTE COUNT");
+
+ if ( (iend = skiprest(rest)) == 1 )
+  return badcast("CAST DOES NOT END A LINE");
+
+ return iend;
+
+}
+
+/***************************************************************
+
+              FUNCTION SECONDS
+
+ SECONDS RETURNS THE TIME IN SECONDS FROM A MONOTONIC CLOCK
+
+***************************************************************/
+
+double seconds()
+
+{
+
+ struct timespec ts;
+
+ clock_gettime(CLOCK_MONOTONIC,&ts);
+ return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATOPEN
+
+ STATOPEN OPENS A WOD FILE FOR READING THROUGH A STREAM WHICH
+ TIMES AND COUNTS EVERY READ FROM THE FILE (STATREAD), SO TIME
+ WAITING FOR INPUT IS KEPT APART FROM DECODING TIME
+
+***************************************************************/
+
+FILE *statopen(char *infile)
+
+{
+
+ static cookie_io_functions_t io = { statread, NULL, statseek, statclose };
+ FILE *f;
+
+ if ( (statfd = open(infile,O_RDONLY)) == -1 ) return NULL;
+ if ( (f = fopencookie(&statfd,"rb",io)) == NULL ) close(statfd);
+ return f;
+
+}
+
+ssize_t statread(void *cookie, char *buf, size_t n)
+
+{
+
+ double t0= seconds();
+ ssize_t r= read(*(int *)cookie,buf,n);
+
+ runstats.tinput += seconds() - t0;
+ if ( r > 0 ) runstats.nread += r;
+ return r;
+
+}
+
+int statseek(void *cookie, off64_t *offset, int whence)
+
+{
+
+ off64_t r= lseek(*(int *)cookie,*offset,whence);
+
+ if ( r == -1 ) return -1;
+ *offset= r;
+ return 0;
+
+}
+
+int statclose(void *cookie)
+
+{
+
+ return close(*(int *)cookie);
+
+}
+
+/***************************************************************
+
+              FUNCTION STATWRITE
+
+ STATWRITE WRITES THE ROWS OF THE PRESENT CAST, FORMATTED INTO
+ MEMORY BY PRINTSTATION, TO THE CSV FILE
+
+***************************************************************/
+
+statwrite()
+
+{
+
+ long len;
+
+ fflush(fpcast);
+ len= ftell(fpcast);
+ fseek(fpcast,0L,SEEK_SET);
+ if ( len <= 0 ) return 0;
+
+ runstats.nwrite += len;
+ if ( fwrite(castbuf,1,len,fpfile) != len ) {
+  printf("UNABLE TO WRITE CSV FILE\n");
+  return -1;
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATADD
+
+ STATADD ADDS THE TIME ONE CAST SPENT IN A STAGE (0 HEADER
+ DECODE, 1 LEVEL DECODE, 2 FORMAT, 3 WRITE) TO THE STAGE TOTAL
+ AND TO THE LATENCY HISTOGRAM OF THE STAGE
+
+***************************************************************/
+
+statadd(int stage, double t)
+
+{
+
+ long us= t * 1.e6;
+ int b= 0;
+
+ if ( stage == 0 ) runstats.theader += t;
+ else if ( stage == 1 ) runstats.tlevel += t;
+ else if ( stage == 2 ) runstats.tformat += t;
+ else runstats.twrite += t;
+
+ while ( us > 0 && b < nbucket-1 ) {
+  us >>= 1;
+  b++;
+ }
+ runstats.hist[stage][b]++;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATSUM
+
+ STATSUM ADDS THE STATISTICS OF ONE WORKER TO THIS PROCESS'S
+
+***************************************************************/
+
+statsum(struct runstat *w)
+
+{
+
+ int j, b;
+
+ runstats.ncast += w->ncast;
+ runstats.nskip += w->nskip;
+ runstats.nbad += w->nbad;
+ runstats.nlevel += w->nlevel;
+ runstats.nvalue += w->nvalue;
+ runstats.nmissing += w->nmissing;
+ runstats.nread += w->nread;
+ runstats.nwrite += w->nwrite;
+ runstats.tinput += w->tinput;
+ runstats.theader += w->theader;
+ runstats.tlevel += w->tlevel;
+ runstats.tformat += w->tformat;
+ runstats.twrite += w->twrite;
+ for ( j = 0; j < nstage; j++ )
+  for ( b = 0; b < nbucket; b++ ) runstats.hist[j][b] += w->hist[j][b];
+ if ( w->zsizemax > runstats.zsizemax ) runstats.zsizemax= w->zsizemax;
+ if ( w->isizemax > runstats.isizemax ) runstats.isizemax= w->isizemax;
+ if ( w->ntsetsmax > runstats.ntsetsmax ) runstats.ntsetsmax= w->ntsetsmax;
+ if ( w->ntentmax > runstats.ntentmax ) runstats.ntentmax= w->ntentmax;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATPEAK
+
+ STATPEAK RECORDS THE LARGEST ARRAY SIZES SPACER HAS HAD TO
+ ALLOCATE IN THIS PROCESS, KEEPING ANY LARGER ONES ALREADY
+ SUMMED FROM WORKERS
+
+***************************************************************/
+
+statpeak(struct runstat *w)
+
+{
+
+ if ( zsizemax > w->zsizemax ) w->zsizemax= zsizemax;
+ if ( isizemax > w->isizemax ) w->isizemax= isizemax;
+ if ( ntsetsmax > w->ntsetsmax ) w->ntsetsmax= ntsetsmax;
+ if ( ntentmax > w->ntentmax ) w->ntentmax= ntentmax;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATREPORT
+
+ STATREPORT PRINTS THE RUN STATISTICS.  WITH SEVERAL WORKERS
+ THE STAGE TIMES ARE SUMMED OVER ALL WORKERS, SO THEY MAY ADD
+ UP TO MORE THAN THE ELAPSED TIME.
+
+***************************************************************/
+
+statreport(double elapsed)
+
+{
+
+ static char *stage[] = { "INPUT", "HEADER DECODE", "LEVEL DECODE",
+                          "FORMAT", "OUTPUT WRITE" };
+ double t[5], tsum= 0.;
+ long lo;
+ int j, b, bmax= 0;
+
+ *t= runstats.tinput;
+ *(t+1)= runstats.theader;
+ *(t+2)= runstats.tlevel;
+ *(t+3)= runstats.tformat;
+ *(t+4)= runstats.twrite;
+ for ( j = 0; j < 5; j++ ) tsum += *(t+j);
+ if ( tsum <= 0. ) tsum= 1.e-9;
+
+ printf("\n RUN STATISTICS\n");
+ printf(" CASTS CONVERTED %14ld\n",runstats.ncast);
+ printf(" CASTS SKIPPED   %14ld\n",runstats.nskip);
+ printf(" BAD CASTS       %14ld\n",runstats.nbad);
+ printf(" LEVELS          %14ld\n",runstats.nlevel);
+ printf(" VALUES          %14ld\n",runstats.nvalue);
+ printf(" MISSING VALUES  %14ld\n",runstats.nmissing);
+ printf(" BYTES READ      %14ld\n",runstats.nread);
+ printf(" BYTES WRITTEN   %14ld\n",runstats.nwrite);
+
+ printf("\n STAGE              SECONDS  PERCENT\n");
+ for ( j = 0; j < 5; j++ )
+  printf(" %-14s %11.4f %8.1f\n",*(stage+j),*(t+j),100. * *(t+j) / tsum);
+ printf(" %-14s %11.4f\n","ELAPSED",elapsed);
+
+ for ( j = 0; j < nstage; j++ )
+  for ( b = 0; b < nbucket; b++ )
+   if ( runstats.hist[j][b] > 0 && b > bmax ) bmax= b;
+
+ printf("\n CASTS BY LATENCY PER STAGE\n");
+ printf(" MICROSECONDS        HEADER     LEVELS     FORMAT      WRITE\n");
+ for ( b = 0; b <= bmax; b++ ) {
+  lo= ( b == 0 ) ? 0 : 1L << (b-1);
+  if ( b == nbucket-1 ) printf(" %8ld OR MORE ",lo);
+  else printf(" %8ld - %-7ld",lo,(1L << b) - 1);
+  for ( j = 0; j < nstage; j++ ) printf(" %10ld",runstats.hist[j][b]);
+  printf("\n");
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION STATJSON
+
+ STATJSON WRITES THE RUN STATISTICS TO A JSON FILE FOR JOB
+ MONITORING.  THE REPORT IS WRITTEN TO NAME.TMP AND RENAMED, SO
+ A READER NEVER SEES A PARTLY WRITTEN FILE.  SPACER_BYTES IS THE
+ MEMORY HELD BY THE DEPTH, DATA AND TAXA ARRAYS AT THEIR LARGEST.
+
+***************************************************************/
+
+statjson(char *name, double elapsed, int nworkers, int status)
+
+{
+
+ static char *stage[] = { "header_decode", "level_decode", "format",
+                          "output_write" };
+ char tmpname[maxname];
+ FILE *f;
+ double t= ( elapsed > 0. ) ? elapsed : 1.e-9;
+ long bytes;
+ int j, b, bmax= 0;
+
+ snprintf(tmpname,maxname,"%s.tmp",name);
+ if ((f = fopen(tmpname,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",tmpname);
+  return -1;
+ }
+
+ bytes= ( 6L * runstats.zsizemax + 6L * runstats.isizemax +
+          2L * runstats.ntsetsmax + 1 + 7L * runstats.ntentmax )
+        * sizeof(int);
+
+ for ( j = 0; j < nstage; j++ )
+  for ( b = 0; b < nbucket; b++ )
+   if ( runstats.hist[j][b] > 0 && b > bmax ) bmax= b;
+
+ fprintf(f,"{\n");
+ fprintf(f,"  \"inputs\": %d,\n",ninput);
+ fprintf(f,"  \"inputs_failed\": %d,\n",ninputfail);
+ fprintf(f,"  \"workers\": %d,\n",nworkers);
+ fprintf(f,"  \"exit_status\": %d,\n",status);
+ fprintf(f,"  \"elapsed_s\": %.6f,\n",elapsed);
+ fprintf(f,"  \"casts_converted\": %ld,\n",runstats.ncast);
+ fprintf(f,"  \"casts_skipped\": %ld,\n",runstats.nskip);
+ fprintf(f,"  \"casts_bad\": %ld,\n",runstats.nbad);
+ fprintf(f,"  \"levels\": %ld,\n",runstats.nlevel);
+ fprintf(f,"  \"values\": %ld,\n",runstats.nvalue);
+ fprintf(f,"  \"missing_values\": %ld,\n",runstats.nmissing);
+ fprintf(f,"  \"bytes_read\": %ld,\n",runstats.nread);
+ fprintf(f,"  \"bytes_written\": %ld,\n",runstats.nwrite);
+ fprintf(f,"  \"throughput\": {\n");
+ fprintf(f,"    \"mb_read_per_s\": %.3f,\n",
+         runstats.nread / ( 1024. * 1024. ) / t);
+ fprintf(f,"    \"mb_written_per_s\": %.3f,\n",
+         runstats.nwrite / ( 1024. * 1024. ) / t);
+ fprintf(f,"    \"casts_per_s\": %.1f\n",runstats.ncast / t);
+ fprintf(f,"  },\n");
+ fprintf(f,"  \"high_water\": {\n");
+ fprintf(f,"    \"zsizemax\": %d,\n",runstats.zsizemax);
+ fprintf(f,"    \"isizemax\": %d,\n",runstats.isizemax);
+ fprintf(f,"    \"ntsetsmax\": %d,\n",runstats.ntsetsmax);
+ fprintf(f,"    \"ntentmax\": %d,\n",runstats.ntentmax);
+ fprintf(f,"    \"spacer_bytes\": %ld\n",bytes);
+ fprintf(f,"  },\n");
+ fprintf(f,"  \"stages_s\": {\n");
+ fprintf(f,"    \"input\": %.6f,\n",runstats.tinput);
+ fprintf(f,"    \"header_decode\": %.6f,\n",runstats.theader);
+ fprintf(f,"    \"level_decode\": %.6f,\n",runstats.tlevel);
+ fprintf(f,"    \"format\": %.6f,\n",runstats.tformat);
+ fprintf(f,"    \"output_write\": %.6f\n",runstats.twrite);
+ fprintf(f,"  },\n");
+
+/***************************************************************
+
+ LATENCY HISTOGRAMS: ELEMENT B COUNTS CASTS TAKING UNDER 2**B
+ MICROSECONDS (AND AT LEAST 2**(B-1))
+
+****************************************************************/
+
+ fprintf(f,"  \"cast_latency_us_log2\": {\n");
+ for ( j = 0; j < nstage; j++ ) {
+  fprintf(f,"    \"%s\": [",*(stage+j));
+  for ( b = 0; b <= bmax; b++ )
+   fprintf(f,"%s%ld",( b == 0 ) ? "" : ", ",runstats.hist[j][b]);
+  fprintf(f,"]%s\n",( j < nstage-1 ) ? "," : "");
+ }
+ fprintf(f,"  }\n");
+ fprintf(f,"}\n");
+
+ if ( fclose(f) != 0 || rename(tmpname,name) != 0 ) {
+  printf("UNABLE TO WRITE FILE %s\n",name);
+  return -1;
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION ADDSECCOLS
+
+ ADDSECCOLS READS A COMMA SEPARATED LIST OF SECONDARY HEADER CODES
+ TO BE WRITTEN AS CSV COLUMNS, AND TURNS ON DECODING OF SECONDARY
+ HEADERS
+
+***************************************************************/
+
+addseccols(char *list)
+
+{
+
+ char *p= list, *e;
+ long code;
+
+ while ( *p != '\0' ) {
+
+  code= strtol(p,&e,10);
+  if ( e == p || code <= 0 || ( *e != ',' && *e != '\0' ) ) {
+   printf("BAD SECONDARY HEADER CODE LIST %s\n",list);
+   return -1;
+  }
+  if ( nseccol >= maxsec ) {
+   printf("TOO MANY SECONDARY HEADER CODES (MAXIMUM %d)\n",maxsec);
+   return -1;
+  }
+  *(seccol+nseccol++)= code;
+  p= ( *e == ',' ) ? e+1 : e;
+
+ }
+
+ secinfo= 1;
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION QCFLAGS
+
+ QCFLAGS RETURNS THE BIT MASK OF THE WOD FLAGS (0 TO 9) IN THE
+ COMMA SEPARATED LIST, OR -1 IF THE LIST IS NOT VALID
+
+***************************************************************/
+
+qcflags(char *list)
+
+{
+
+ char *p= list, *e;
+ long flag;
+ int mask=0;
+
+ while ( *p != '\0' ) {
+
+  flag= strtol(p,&e,10);
+  if ( e == p || flag < 0 || flag > 9 || ( *e != ',' && *e != '\0' ) ) {
+   printf("BAD FLAG LIST %s (FLAGS 0 TO 9)\n",list);
+   return -1;
+  }
+  mask |= 1 << flag;
+  p= ( *e == ',' ) ? e+1 : e;
+
+ }
+
+ return mask;
+
+}
+
+/***************************************************************
+
+              FUNCTION IDLOAD
+
+ IDLOAD READS THE WOD UNIQUE NUMBERS SELECTED (-id) FROM FILE NAME,
+ SEPARATED BY BLANKS, COMMAS OR NEW LINES, AND SORTS THEM.
+ RETURNS ZERO, OR -1 IF THE FILE CANNOT BE READ OR HAS NO NUMBERS.
+
+***************************************************************/
+
+idload(char *name)
+
+{
+
+ FILE *fpid;
+ int id, nmax=nidlist;
+
+ if ((fpid = fopen(name,"r\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",name);
+  return -1;
+ }
+
+ while ( fscanf(fpid," %d ,",&id) == 1 ) {
+
+  if ( nidlist >= nmax ) {
+   nmax= ( nmax == 0 ) ? 4096 : 2 * nmax;
+   if ( (idlist = realloc(idlist,nmax * sizeof(int))) == NULL ) {
+    printf(" NOT ENOUGH SPACE IN MEMORY FOR %d WOD UNIQUE NUMBERS\n",
+           nmax);
+    fclose(fpid);
+    return -1;
+   }
+  }
+  *(idlist+nidlist++)= id;
+
+ }
+
+ fclose(fpid);
+
+ if ( nidlist == 0 ) {
+  printf("NO WOD UNIQUE NUMBERS IN %s\n",name);
+  return -1;
+ }
+
+ qsort(idlist,nidlist,sizeof(int),byint);
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION CRUISELOAD
+
+ CRUISELOAD ADDS THE CRUISES IN THE COMMA SEPARATED LIST (-cruise)
+ TO THOSE SELECTED.  EACH IS A CRUISE NUMBER, WITH OR WITHOUT ITS
+ TWO LETTER COUNTRY CODE IN FRONT.  RETURNS ZERO, OR -1 IF THE LIST
+ IS NOT VALID.
+
+***************************************************************/
+
+cruiseload(char *list)
+
+{
+
+ char *p= list, *e;
+ struct cruisesel *c;
+ long icr;
+
+ while ( *p != '\0' ) {
+
+  if ( (cruiselist = realloc(cruiselist,(ncruise+1) *
+                             sizeof(struct cruisesel))) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %d CRUISES\n",ncruise+1);
+   return -1;
+  }
+  c= cruiselist+ncruise;
+
+  *(c->cc)= '\0';
+  if ( isalpha(*p) && isalpha(*(p+1)) ) {
+   strncpy(c->cc,p,2);
+   *(c->cc+2)= '\0';
+   p += 2;
+  }
+
+  icr= strtol(p,&e,10);
+  if ( e == p || icr < 0 || ( *e != ',' && *e != '\0' ) ) {
+   printf("BAD CRUISE LIST %s (E.G. US38379,38378)\n",list);
+   return -1;
+  }
+  c->icruise= icr;
+  ncruise++;
+  p= ( *e == ',' ) ? e+1 : e;
+
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION CASTSELECT
+
+ CASTSELECT RETURNS ONE IF THE PRESENT CAST IS IN THE WOD UNIQUE
+ NUMBER LIST (-id) AND THE CRUISE LIST (-cruise), WHEN GIVEN
+
+***************************************************************/
+
+castselect()
+
+{
+
+ int j;
+
+ if ( nidlist > 0 &&
+      bsearch(&ostation,idlist,nidlist,sizeof(int),byint) == NULL )
+  return 0;
+
+ if ( ncruise == 0 ) return 1;
+
+ for ( j = 0; j < ncruise; j++ )
+  if ( (cruiselist+j)->icruise == icruise &&
+       ( *((cruiselist+j)->cc) == '\0' ||
+         strncmp((cruiselist+j)->cc,cc,2) == 0 ) ) return 1;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION QCOK
+
+ QCOK RETURNS ONE IF FLAG IS ACCEPTED BY MASK
+
+***************************************************************/
+
+qcok(int mask, int flag)
+
+{
+
+ if ( mask == ~0 ) return 1;
+ return ( flag >= 0 && flag <= 9 && ( mask >> flag ) & 1 );
+
+}
+
+/***************************************************************
+
+              FUNCTION QCVALUE
+
+ QCVALUE RETURNS ONE IF THE VALUE OF VARIABLE J (POSITION IN IP2)
+ AT LEVEL K IS PRESENT AND ITS FLAG IS ACCEPTED
+
+***************************************************************/
+
+qcvalue(int j, int k)
+
+{
+
+ int offs= j * levels + k;
+
+ return ( *(dtotfig+offs) > 0 && qcok(qcd,*(derr+offs)) );
+
+}
+
+/***************************************************************
+
+              FUNCTION QCLEVEL
+
+ QCLEVEL RETURNS ONE IF LEVEL K IS TO BE WRITTEN: ITS DEPTH FLAG
+ IS ACCEPTED AND IT HAS AN ACCEPTED VALUE OF VARIABLE J (POSITION
+ IN IP2), OR OF ANY VARIABLE WITH AN ACCEPTED PROFILE IF J IS -1
+
+***************************************************************/
+
+qclevel(int k, int j)
+
+{
+
+ if ( !qcok(qcz,*(zerr+k)) ) return 0;
+ if ( j >= 0 ) return qcvalue(j,k);
+
+ for ( j = 0; j < nparm; j++ )
+  if ( *(profok+j) && *(ip2+j) >= 1 && *(ip2+j) <= nvars &&
+       qcvalue(j,k) ) return 1;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION LEVELOUT
+
+ LEVELOUT RETURNS ONE IF LEVEL K OF THE CAST IS WRITTEN (IN MODE
+ A): IT HAS A VALUE OF VARIABLE J (POSITION IN IP2, -1 FOR ALL
+ VARIABLES) WHICH PASSES QUALITY CONTROL
+
+***************************************************************/
+
+levelout(int k, int j)
+
+{
+
+ if ( j >= 0 && *(dsigfig+j*levels+k) <= 0 ) return 0;
+ if ( qcmode == 1 ) return qclevel(k,j);
+ return 1;
+
+}
+
+/***************************************************************
+
+              FUNCTION SECFILL
+
+ SECFILL FORMATS THE SELECTED SECONDARY HEADERS OF THE PRESENT
+ CAST INTO SECROW, ONCE PER CAST, TO BE ADDED TO EACH ROW
+
+***************************************************************/
+
+secfill()
+
+{
+
+ char *p= secrow;
+ int j, k;
+
+ for ( k = 0; k < nseccol; k++ ) {
+
+  *p++= ',';
+  for ( j = 0; j < nsec; j++ )
+   if ( *(seccode+j) == *(seccol+k) ) break;
+
+  if ( j < nsec && *(stotfig+j) > 0 ) {
+   if ( *(srightfig+j) > 0 )
+    p += sprintf(p,"%.*f",*(srightfig+j),
+                 *(secval+j) / tenp[*(srightfig+j)]);
+   else p += sprintf(p,"%d",*(secval+j));
+  }
+
+ }
+
+ *p= '\0';
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PSECNAME
+
+ PSECNAME SETS THE NAME OF THE SIDE TABLE OF VARIABLE SPECIFIC
+ SECONDARY HEADERS FOR OUTPUT FILE OUTFILE: NAME.CSV BECOMES
+ NAME.PSEC.CSV, ANY OTHER NAME (A PART FILE) GETS .PSEC ADDED
+
+***************************************************************/
+
+psecname(char *name, char *outfile)
+
+{
+
+ int n= strlen(outfile);
+
+ if ( n > 4 && strcmp(outfile+n-4,".csv") == 0 )
+  snprintf(name,maxname,"%.*s.psec.csv",n-4,outfile);
+ else snprintf(name,maxname,"%s.psec",outfile);
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PSECOPEN
+
+ PSECOPEN OPENS THE SIDE TABLE FOR OUTPUT FILE OUTFILE AND WRITES
+ ITS COLUMN HEADER (NOT FOR PART FILES, WHICH ARE MERGED LATER)
+
+***************************************************************/
+
+psecopen(char *outfile)
+
+{
+
+ char name[maxname];
+
+ psecname(name,outfile);
+ if ((fppsec = fopen(name,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",name);
+  return -1;
+ }
+
+ if ( noheader == 0 )
+  fprintf(fppsec,"%s\n",psechead);
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PRINTPSEC
+
+ PRINTPSEC WRITES ONE SIDE TABLE ROW FOR EACH VARIABLE SPECIFIC
+ SECONDARY HEADER OF THE PRESENT CAST (ONLY FOR VARIABLE JCHOICE
+ IF ONE WAS CHOSEN)
+
+***************************************************************/
+
+printpsec(int jchoice)
+
+{
+
+ int j, v;
+
+ for ( j = 0; j < npsec; j++ ) {
+
+  v= *(psecparm+j);
+  if ( jchoice != 0 && v != jchoice ) continue;
+
+  fprintf(fppsec,"%d,%d,%s,%d,",ostation,v,
+          ( v >= 1 && v <= nvars ) ? namevar[v-1] : "",*(pseccode+j));
+  if ( *(pstotfig+j) > 0 ) {
+   if ( *(psrightfig+j) > 0 )
+    fprintf(fppsec,"%.*f",*(psrightfig+j),
+            *(psecval+j) / tenp[*(psrightfig+j)]);
+   else fprintf(fppsec,"%d",*(psecval+j));
+  }
+  fprintf(fppsec,"\n");
+
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION MERGEPSEC
+
+ MERGEPSEC WRITES THE SIDE TABLE FOR MERGENAME FROM THE SIDE TABLE
+ PARTS OF EACH INPUT FILE, IN INPUT ORDER, REMOVING THE PARTS.
+ RETURNS THE NUMBER OF MISSING PARTS.
+
+***************************************************************/
+
+mergepsec(char *mergename)
+
+{
+
+ char outname[maxname], partfile[maxname], buf[65536];
+ FILE *fpside, *fppart;
+ size_t n;
+ int j, nmiss=0;
+
+ psecname(outname,mergename);
+ if ((fpside = fopen(outname,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",outname);
+  return 1;
+ }
+
+ fprintf(fpside,"%s\n",psechead);
+
+ for ( j = 0; j < ninput; j++ ) {
+
+  partname(partfile,*(inputs+j),mergename,j);
+  psecname(outname,partfile);
+  if ((fppart = fopen(outname,"rb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",outname);
+   nmiss++;
+   continue;
+  }
+
+  while ( (n = fread(buf,1,sizeof(buf),fppart)) > 0 )
+   fwrite(buf,1,n,fpside);
+
+  fclose(fppart);
+  remove(outname);
+
+ }
+
+ fclose(fpside);
+ return nmiss;
+
+}
+
+/***************************************************************
+
+              FUNCTION ADDINPUT
+
+ ADDINPUT ADDS A WOD FILE TO THE LIST OF FILES TO CONVERT.  A
+ DIRECTORY IS SEARCHED (INCLUDING SUBDIRECTORIES) AND EVERY
+ FILE IN IT THAT IS NOT CONVERTER OUTPUT OR AN ARCHIVE IS ADDED.
+ A FILE OR DIRECTORY WHICH CANNOT BE READ IS COUNTED IN NINPUTFAIL.
+
+***************************************************************/
+
+addinput(char *name)
+
+{
+
+ struct stat st;
+ DIR *dir;
+ struct dirent *ent;
+ char path[maxname];
+ int n;
+
+ if ( stat(name,&st) != 0 ) {
+  printf("UNABLE TO OPEN FILE %s\n",name);
+  ninputfail++;
+  return -1;
+ }
+
+ if ( S_ISDIR(st.st_mode) ) {
+
+  if ( (dir = opendir(name)) == NULL ) {
+   printf("UNABLE TO OPEN DIRECTORY %s\n",name);
+   ninputfail++;
+   return -1;
+  }
+
+  while ( (ent = readdir(dir)) != NULL ) {
+
+   if ( *(ent->d_name) == '.' || skipname(ent->d_name) ) continue;
+   snprintf(path,maxname,"%s/%s",name,ent->d_name);
+   addinput(path);
+
+  }
+
+  closedir(dir);
+  return 0;
+
+ }
+
+ if ( ninput >= ninputmax ) {
+  ninputmax= ( ninputmax == 0 ) ? 64 : 2 * ninputmax;
+  if ( (inputs = realloc(inputs, ninputmax * sizeof(char *))) == NULL ||
+       (inputsize = realloc(inputsize, ninputmax * sizeof(long))) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %d INPUT FILES\n",ninputmax);
+   exit(1);
+  }
+ }
+
+ n= strlen(name);
+ if ( (*(inputs+ninput) = malloc(n+1)) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %d INPUT FILES\n",ninput);
+  exit(1);
+ }
+ strcpy(*(inputs+ninput),name);
+ *(inputsize+ninput)= st.st_size;
+ ninput++;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION ADDLIST
+
+ ADDLIST READS WOD FILE (OR DIRECTORY) NAMES FROM A LIST FILE,
+ ONE PER LINE
+
+***************************************************************/
+
+addlist(char *listname)
+
+{
+
+ char line[maxname];
+ int n;
+
+ if ((fplist = fopen(listname,"r\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",listname);
+  ninputfail++;
+  return -1;
+ }
+
+ while ( fgets(line,maxname,fplist) != NULL ) {
+
+  n= strlen(line);
+  while ( n > 0 && isspace(*(line+n-1)) ) *(line+(--n))= '\0';
+  if ( n > 0 ) addinput(line);
+
+ }
+
+ fclose(fplist);
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION SKIPNAME
+
+ SKIPNAME RETURNS ONE FOR FILES FOUND IN A DIRECTORY WHICH ARE
+ NOT WOD NATIVE FORMAT INPUT (CONVERTER OUTPUT, ARCHIVES, ETC.).
+ A -W SUBSET NAME.SUB IS NATIVE FORMAT BUT IS SKIPPED TOO, OR THE
+ NEXT RUN ON THE DIRECTORY WOULD CONVERT ITS CASTS TWICE.
+ FILES LEFT BY AN INTERRUPTED RUN END IN A NUMBERED SUFFIX: MERGE
+ PARTS NAME.PARTN, SORTED RUNS NAME.RUNN (OR NAME.WK.RUNN) AND
+ SPLIT RANGES NAME.RN (-P).
+
+***************************************************************/
+
+skipname(char *name)
+
+{
+
+ static char *suffix[] = { ".csv", ".gz", ".tar", ".zip", ".exe",
+                           ".sdx", ".tdx", ".tmp", ".psec", ".json",
+                           ".sub", NULL };
+ static char *numbered[] = { ".part", ".run", ".r", NULL };
+ int j, n= strlen(name), ns;
+ char *p, *d;
+
+ for ( j = 0; *(suffix+j) != NULL; j++ ) {
+  ns= strlen(*(suffix+j));
+  if ( n >= ns && strcmp(name+n-ns,*(suffix+j)) == 0 ) return 1;
+ }
+
+/***************************************************************
+
+ A NUMBERED SUFFIX: THE LAST DOT, ONE OF THE WORDS, THEN ONLY DIGITS
+
+****************************************************************/
+
+ if ( (p = strrchr(name,'.')) == NULL ) return 0;
+
+ for ( j = 0; *(numbered+j) != NULL; j++ ) {
+  ns= strlen(*(numbered+j));
+  if ( strncmp(p,*(numbered+j),ns) != 0 || *(p+ns) == '\0' ) continue;
+  for ( d = p+ns; isdigit(*d); d++ );
+  if ( *d == '\0' ) return 1;
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION BATCH
+
+ BATCH CONVERTS ALL INPUT FILES USING NWORKERS PROCESSES.
+ FILES ARE HANDED OUT LARGEST FIRST FROM A COUNTER SHARED BY
+ ALL WORKERS, SO A WORKER THAT FINISHES EARLY TAKES THE NEXT
+ FILE WAITING INSTEAD OF SITTING IDLE.  A SINGLE WORKER TAKES
+ THE FILES IN INPUT ORDER.  EACH FILE IS WRITTEN
+ TO FILENAME.CSV, OR, IF MERGENAME IS GIVEN, TO A PART FILE
+ WHICH IS APPENDED TO MERGENAME IN INPUT ORDER AT THE END.
+
+***************************************************************/
+
+batch(int nworkers, char *mergename, int ncast, int jchoice)
+
+{
+
+ int *order, *nextfile, onefile;
+ int j, k, r, nfail=0, status;
+ char outname[maxname], **runs;
+ struct runstat *slot=NULL;
+ pid_t pid;
+
+ if ( (order = malloc(ninput * sizeof(int))) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %d INPUT FILES\n",ninput);
+  return 1;
+ }
+ for ( j = 0; j < ninput; j++ ) *(order+j)= j;
+ if ( nworkers > 1 ) qsort(order,ninput,sizeof(int),bysize);
+
+ if ( (nextfile = mmap(NULL,sizeof(int),PROT_READ|PROT_WRITE,
+                 MAP_SHARED|MAP_ANONYMOUS,-1,0)) == MAP_FAILED ) {
+  printf(" UNABLE TO SHARE FILE COUNTER, USING ONE PROCESS\n");
+  nworkers= 1;
+  nextfile= &onefile;
+ }
+ *nextfile= 0;
+
+ if ( nworkers > ninput ) nworkers= ninput;
+ if ( mergename != NULL ) noheader= 1;
+
+ if ( statmode == 1 && nworkers > 1 &&
+      (slot = mmap(NULL,nworkers * sizeof(struct runstat),
+              PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0))
+      == MAP_FAILED ) {
+  printf(" UNABLE TO SHARE RUN STATISTICS, USING ONE PROCESS\n");
+  nworkers= 1;
+  slot= NULL;
+ }
+
+ for ( k = 0; k < nworkers; k++ ) {
+
+  pid= ( nworkers == 1 ) ? 0 : fork();
+
+  if ( pid == -1 ) {
+   printf(" UNABLE TO START WORKER %d\n",k);
+   continue;
+  }
+
+  if ( pid == 0 ) {
+
+/***************************************************************
+
+ WORKER: TAKE THE NEXT FILE WAITING UNTIL NONE ARE LEFT.  WHEN
+ MERGING PARTITIONED OUTPUT THE WORKER KEEPS ITS CASTS IN
+ MEMORY ACROSS FILES AND WRITES SORTED RUNS FOR THE MERGE.
+
+****************************************************************/
+
+   if ( partmode != 0 && mergename != NULL )
+    snprintf(runbase,maxname,"%s.w%d",mergename,k);
+
+   while ( (j = __sync_fetch_and_add(nextfile,1)) < ninput ) {
+
+    j= *(order+j);
+    partname(outname,*(inputs+j),mergename,j);
+    if ( convertfile(*(inputs+j),outname,ncast,jchoice) != 0 ) nfail++;
+
+   }
+
+   if ( partmode != 0 && mergename != NULL && partspill() != 0 ) {
+    partdrop(runbase);
+    nfail++;
+   }
+
+   if ( nworkers == 1 ) break;
+   if ( slot != NULL ) {
+    statpeak(&runstats);
+    memcpy(slot+k,&runstats,sizeof(struct runstat));
+   }
+   exit( nfail > 0 );
+
+  }
+
+ }
+
+ while ( nworkers > 1 && wait(&status) > 0 ) {
+  if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) nfail++;
+ }
+
+ if ( slot != NULL ) {
+  for ( k = 0; k < nworkers; k++ ) statsum(slot+k);
+  munmap(slot,nworkers * sizeof(struct runstat));
+ }
+
+ if ( mergename != NULL && partmode != 0 ) {
+
+/***************************************************************
+
+ MERGE THE SORTED RUNS OF ALL WORKERS INTO PARTITION FILES
+
+****************************************************************/
+
+  runs= NULL;
+  for ( r = 0, k = 0; k < nworkers; k++ ) {
+   snprintf(runbase,maxname,"%s.w%d",mergename,k);
+   for ( j = 0; ; j++ ) {
+    if ( runfile(outname,runbase,j) != 0 ) {
+     nfail++;
+     break;
+    }
+    if ( access(outname,F_OK) != 0 ) break;
+    if ( (runs = realloc(runs,(r+1) * sizeof(char *))) == NULL ||
+         (*(runs+r) = strdup(outname)) == NULL ) {
+     printf(" NOT ENOUGH SPACE IN MEMORY FOR %d RUN FILES\n",r+1);
+     return 1;
+    }
+    r++;
+   }
+  }
+
+  partbase(outname,mergename);
+  nfail += partmerge(outname,runs,r,jchoice);
+  for ( k = 0; k < r; k++ ) free(*(runs+k));
+  free(runs);
+
+ }
+
+ else if ( mergename != NULL ) nfail += mergeparts(mergename,jchoice);
+
+ if ( mergename != NULL && psecout == 1 ) nfail += mergepsec(mergename);
+
+ free(order);
+ if ( nfail > 0 ) printf(" %d FILES OR WORKERS FAILED\n",nfail);
+ return ( nfail > 0 );
+
+}
+
+/***************************************************************
+
+              FUNCTION BYSIZE
+
+ BYSIZE ORDERS INPUT FILE NUMBERS LARGEST FILE FIRST (FOR QSORT)
+
+***************************************************************/
+
+bysize(const void *a, const void *b)
+
+{
+
+ long sa= *(inputsize + *(int *)a), sb= *(inputsize + *(int *)b);
+
+ if ( sa != sb ) return ( sa < sb ) ? 1 : -1;
+ return *(int *)a - *(int *)b;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTNAME
+
+ PARTNAME SETS THE OUTPUT FILE NAME FOR INPUT FILE NUMBER J:
+ INFILE.CSV (SEE OUTEXT), OR MERGENAME.PARTJ WHEN MERGING
+
+***************************************************************/
+
+partname(char *outname, char *infile, char *mergename, int j)
+
+{
+
+ if ( mergename == NULL )
+  snprintf(outname,maxname,"%s%s",infile,outext());
+ else snprintf(outname,maxname,"%s.part%d",mergename,j);
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION OUTEXT
+
+ OUTEXT RETURNS THE ENDING ADDED TO AN INPUT FILE NAME FOR ITS
+ OUTPUT: .SUB FOR A NATIVE FORMAT SUBSET, .INV.CSV FOR AN
+ INVENTORY, .CSV OTHERWISE
+
+***************************************************************/
+
+char *outext()
+
+{
+
+ if ( subsetmode == 1 ) return ".sub";
+ if ( invmode == 1 ) return ".inv.csv";
+ return ".csv";
+
+}
+
+/***************************************************************
+
+              FUNCTION SEENINIT
+
+ SEENINIT SETS UP THE BITMAP OF WOD UNIQUE NUMBERS ALREADY
+ CONVERTED.  THE MAP IS SHARED WITH ALL WORKER PROCESSES.  IT
+ RESERVES ONE BIT FOR EVERY POSSIBLE NUMBER, BUT MEMORY IS ONLY
+ USED FOR THE PAGES COVERING NUMBERS ACTUALLY SEEN.
+
+***************************************************************/
+
+seeninit()
+
+{
+
+ size_t nbytes= (size_t)maxunique / 8 + 1;
+
+ if ( (seencast = mmap(NULL,nbytes,PROT_READ|PROT_WRITE,
+       MAP_SHARED|MAP_ANONYMOUS|MAP_NORESERVE,-1,0)) == MAP_FAILED ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR WOD UNIQUE NUMBERS\n");
+  seencast= NULL;
+  return -1;
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION SEENBEFORE
+
+ SEENBEFORE RETURNS ONE IF WOD UNIQUE NUMBER ID IS ALREADY MARKED
+ AS CONVERTED (BY THIS OR ANY OTHER WORKER), WITHOUT MARKING IT
+
+***************************************************************/
+
+seenbefore(int id)
+
+{
+
+ unsigned int bit;
+
+ if ( seencast == NULL || id < 0 ) return 0;
+
+ bit= 1u << (id & 31);
+ return ( __atomic_load_n(seencast+(id >> 5),__ATOMIC_RELAXED) & bit )
+        != 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION SEENMARK
+
+ SEENMARK MARKS WOD UNIQUE NUMBER ID AS CONVERTED.  RETURNS ONE
+ IF IT WAS ALREADY MARKED (BY THIS OR ANY OTHER WORKER), SO OF TWO
+ WORKERS READING THE SAME CAST AT ONCE ONLY ONE CONVERTS IT.
+
+***************************************************************/
+
+seenmark(int id)
+
+{
+
+ unsigned int bit;
+
+ if ( seencast == NULL || id < 0 ) return 0;
+
+ bit= 1u << (id & 31);
+ return ( __sync_fetch_and_or(seencast+(id >> 5),bit) & bit ) != 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION MERGEPARTS
+
+ MERGEPARTS WRITES THE COLUMN HEADER TO MERGENAME AND APPENDS
+ THE PART FILE OF EACH INPUT FILE IN INPUT ORDER, REMOVING THE
+ PART FILES.  RETURNS THE NUMBER OF MISSING PARTS.
+
+***************************************************************/
+
+mergeparts(char *mergename, int jchoice)
+
+{
+
+ char outname[maxname], buf[65536];
+ FILE *fppart;
+ size_t n;
+ int j, nmiss=0;
+
+ if ((fpout = fopen(mergename,"w\0")) == NULL) {
+  printf("UNABLE TO OPEN FILE %s\n",mergename);
+  return 1;
+ }
+
+ printheader(jchoice);
+
+ for ( j = 0; j < ninput; j++ ) {
+
+  partname(outname,*(inputs+j),mergename,j);
+  if ((fppart = fopen(outname,"rb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",outname);
+   nmiss++;
+   continue;
+  }
+
+  while ( (n = fread(buf,1,sizeof(buf),fppart)) > 0 )
+   fwrite(buf,1,n,fpout);
+
+  fclose(fppart);
+  remove(outname);
+
+ }
+
+ fclose(fpout);
+ return nmiss;
+
+}
+/***************************************************************
+
+              FUNCTION PARTBASE
+
+ PARTBASE SETS THE NAME PREFIX FOR PARTITION FILES: THE OUTPUT
+ FILE NAME WITHOUT ITS .CSV ENDING
+
+***************************************************************/
+
+partbase(char *base, char *outfile)
+
+{
+
+ int n;
+
+ snprintf(base,maxname,"%s",outfile);
+ n= strlen(base);
+ if ( n > 4 && strcmp(base+n-4,".csv") == 0 ) *(base+n-4)= '\0';
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTCAST
+
+ PARTCAST POINTS FPOUT AT A MEMORY STREAM SO THAT PRINTSTATION
+ FORMATS EACH CAST INTO MEMORY FOR PARTADD
+
+***************************************************************/
+
+partcast()
+
+{
+
+ if ( fpcast == NULL &&
+      (fpcast = open_memstream(&castbuf,&castlen)) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR CAST OUTPUT\n");
+  return -1;
+ }
+
+ fpout= fpcast;
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTKEY
+
+ PARTKEY RETURNS THE PARTITION OF THE PRESENT CAST: YEAR * 100 +
+ MONTH, OR THE WMO 10 DEGREE SQUARE (QUADRANT, TENS OF DEGREES
+ LATITUDE, TENS OF DEGREES LONGITUDE)
+
+***************************************************************/
+
+partkey()
+
+{
+
+ float xlat, xlon;
+ int iq, ila, ilo;
+
+ if ( partmode == 'M' ) return year * 100 + month;
+
+ xlat= (latitude/ tenp[ *(hrightfig+1) ]);
+ xlon= (longitude/ tenp[ *(hrightfig+2) ]);
+
+ if ( xlat >= 0. ) iq= ( xlon >= 0. ) ? 1 : 7;
+ else iq= ( xlon >= 0. ) ? 3 : 5;
+
+ ila= ( xlat >= 0. ) ? xlat/10. : -xlat/10.;
+ ilo= ( xlon >= 0. ) ? xlon/10. : -xlon/10.;
+ if ( ila > 8 ) ila= 8;
+ if ( ilo > 17 ) ilo= 17;
+
+ return iq * 1000 + ila * 100 + ilo;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTADD
+
+ PARTADD FILES THE ROWS PRINTSTATION WROTE FOR THE PRESENT CAST
+ IN THE RUN BUFFER, WRITING A SORTED RUN TO DISK FIRST IF THE
+ BUFFER WOULD GROW PAST PARTMEM
+
+***************************************************************/
+
+partadd()
+
+{
+
+ struct partrec rec;
+ long need;
+
+ fflush(fpcast);
+ rec.len= ftell(fpcast);
+ fseek(fpcast,0L,SEEK_SET);
+ if ( rec.len <= 0 ) return 0;
+
+ rec.part= partkey();
+ rec.tkey= year * 10000 + month * 100 + day;
+ rec.hkey= hourkey();
+ rec.id= ostation;
+ rec.seq= nrunrec;
+
+/***************************************************************
+
+ RECORDS START ON A LONG BOUNDARY
+
+****************************************************************/
+
+ need= sizeof(rec) + rec.len;
+ need= ( need + sizeof(long) - 1 ) / sizeof(long) * sizeof(long);
+
+ if ( runused + need + nrunrec * sizeof(long) > partmem && nrunrec > 0 ) {
+  if ( partspill() != 0 ) return -1;
+  rec.seq= 0;
+ }
+
+ if ( runused + need > runsize ) {
+  runsize= ( 2 * runsize > runused + need ) ? 2 * runsize : runused + need;
+  if ( (runbuf = realloc(runbuf,runsize)) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld BYTES OF OUTPUT\n",runsize);
+   return -1;
+  }
+ }
+
+ if ( nrunrec >= nrunrecmax ) {
+  nrunrecmax= ( nrunrecmax == 0 ) ? 1024 : 2 * nrunrecmax;
+  if ( (runrec = realloc(runrec,nrunrecmax * sizeof(long))) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %d CASTS\n",nrunrecmax);
+   return -1;
+  }
+ }
+
+ memcpy(runbuf+runused,&rec,sizeof(rec));
+ memcpy(runbuf+runused+sizeof(rec),castbuf,rec.len);
+ *(runrec+nrunrec++)= runused;
+ runused += need;
+ runstats.nwrite += rec.len;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTCMP
+
+ PARTCMP ORDERS TWO CAST RECORDS BY PARTITION, DATE, HOUR, WOD
+ UNIQUE NUMBER AND ORDER OF CONVERSION
+
+***************************************************************/
+
+partcmp(const struct partrec *a, const struct partrec *b)
+
+{
+
+ if ( a->part != b->part ) return ( a->part < b->part ) ? -1 : 1;
+ if ( a->tkey != b->tkey ) return ( a->tkey < b->tkey ) ? -1 : 1;
+ if ( a->hkey != b->hkey ) return ( a->hkey < b->hkey ) ? -1 : 1;
+ if ( a->id != b->id ) return ( a->id < b->id ) ? -1 : 1;
+ if ( a->seq != b->seq ) return ( a->seq < b->seq ) ? -1 : 1;
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION BYPART
+
+ BYPART ORDERS RUN BUFFER OFFSETS BY THEIR CAST RECORDS (FOR QSORT)
+
+***************************************************************/
+
+bypart(const void *a, const void *b)
+
+{
+
+ return partcmp( (struct partrec *)(runbuf + *(long *)a),
+                 (struct partrec *)(runbuf + *(long *)b) );
+
+}
+
+/***************************************************************
+
+              FUNCTION BYINT
+
+ BYINT ORDERS INTEGERS (FOR QSORT AND BSEARCH)
+
+***************************************************************/
+
+byint(const void *a, const void *b)
+
+{
+
+ int ia= *(int *)a, ib= *(int *)b;
+
+ return ( ia > ib ) - ( ia < ib );
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTSPILL
+
+ PARTSPILL SORTS THE CASTS IN THE RUN BUFFER AND WRITES THEM TO
+ RUN FILE RUNBASE.RUNN, THEN EMPTIES THE BUFFER.  RETURNS ZERO, OR
+ -1 IF THIS OR AN EARLIER RUN COULD NOT BE WRITTEN WHOLE (SEE
+ PARTFAIL); A RUN CUT SHORT IS REMOVED.
+
+***************************************************************/
+
+partspill()
+
+{
+
+ char runname[maxname];
+ struct partrec *rec;
+ FILE *fprun;
+ int j;
+
+ if ( nrunrec == 0 ) return -partfail;
+
+ qsort(runrec,nrunrec,sizeof(long),bypart);
+
+ if ( partfail == 1 || runfile(runname,runbase,nrun) != 0 ||
+      (fprun = fopen(runname,"wb\0")) == NULL ) {
+  if ( partfail == 0 ) printf("UNABLE TO OPEN FILE %s\n",runname);
+  partfail= 1;
+  nrunrec= 0;
+  runused= 0;
+  return -1;
+ }
+
+ for ( j = 0; j < nrunrec; j++ ) {
+  rec= (struct partrec *)(runbuf + *(runrec+j));
+  if ( fwrite(rec,1,sizeof(struct partrec) + rec->len,fprun) !=
+       sizeof(struct partrec) + rec->len ) break;
+ }
+
+ if ( fclose(fprun) != 0 || j < nrunrec ) {
+  printf("UNABLE TO WRITE FILE %s\n",runname);
+  remove(runname);
+  partfail= 1;
+  nrunrec= 0;
+  runused= 0;
+  return -1;
+ }
+
+ nrun++;
+ nrunrec= 0;
+ runused= 0;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTDROP
+
+ PARTDROP REMOVES THE RUN FILES WRITTEN UNDER BASE AFTER A RUN
+ COULD NOT BE WRITTEN, SO NO PARTITION FILE IS MADE WITH CASTS
+ MISSING, AND STARTS AGAIN WITH NO RUNS
+
+***************************************************************/
+
+partdrop(char *base)
+
+{
+
+ char runname[maxname];
+ int j;
+
+ for ( j = 0; j < nrun; j++ )
+  if ( runfile(runname,base,j) == 0 ) remove(runname);
+
+ nrun= 0;
+ nrunrec= 0;
+ runused= 0;
+ partfail= 0;
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION RUNFILE
+
+ RUNFILE SETS NAME TO THE NAME OF RUN FILE J, BASE.RUNJ.  RETURNS
+ ZERO, OR -1 IF THE NAME DOES NOT FIT IN MAXNAME (A SHORTENED NAME
+ COULD BE THE SAME FOR TWO RUNS).
+
+***************************************************************/
+
+runfile(char *name, char *base, int j)
+
+{
+
+ if ( snprintf(name,maxname,"%s.run%d",base,j) >= maxname ) {
+  printf(" FILE NAME TOO LONG: %s.run%d\n",base,j);
+  return -1;
+ }
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTFINISH
+
+ PARTFINISH WRITES THE PARTITION FILES FOR ONE CONVERTED FILE
+ FROM ITS RUNS
+
+***************************************************************/
+
+partfinish(char *base, int jchoice)
+
+{
+
+ char **runs;
+ int j, n, iret;
+
+ if ( partspill() != 0 ) {
+  partdrop(base);
+  return -1;
+ }
+
+ n= nrun;
+ if ( (runs = malloc((n+1) * sizeof(char *))) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %d RUN FILES\n",n);
+  return -1;
+ }
+
+ for ( j = 0; j < n; j++ ) {
+  if ( (*(runs+j) = malloc(maxname)) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %d RUN FILES\n",n);
+   return -1;
+  }
+  if ( runfile(*(runs+j),base,j) != 0 ) return -1;
+ }
+
+ iret= partmerge(base,runs,n,jchoice);
+
+ for ( j = 0; j < n; j++ ) free(*(runs+j));
+ free(runs);
+ nrun= 0;
+
+ return iret;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTMERGE
+
+ PARTMERGE MERGES SORTED RUN FILES INTO ONE CSV FILE PER
+ PARTITION, BASE.YYYYMM.CSV OR BASE.QLLL.CSV, AND REMOVES THE
+ RUN FILES.  RETURNS THE NUMBER OF ERRORS.
+
+***************************************************************/
+
+partmerge(char *base, char **runs, int nruns, int jchoice)
+
+{
+
+ FILE **fprun;
+ struct partrec *head;
+ char **body, outname[maxname];
+ int *bodysize, *live;
+ int j, jmin, part, nerr=0;
+
+ fprun= calloc(nruns+1,sizeof(FILE *));
+ head= calloc(nruns+1,sizeof(struct partrec));
+ body= calloc(nruns+1,sizeof(char *));
+ bodysize= calloc(nruns+1,sizeof(int));
+ live= calloc(nruns+1,sizeof(int));
+ if ( fprun == NULL || head == NULL || body == NULL || bodysize == NULL ||
+      live == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %d RUN FILES\n",nruns);
+  for ( j = 0; j < nruns; j++ ) remove(*(runs+j));
+  free(fprun);
+  free(head);
+  free(body);
+  free(bodysize);
+  free(live);
+  return 1;
+ }
+
+/***************************************************************
+
+ OPEN EACH RUN AND READ ITS FIRST CAST
+
+****************************************************************/
+
+ for ( j = 0; j < nruns; j++ ) {
+  if ((*(fprun+j) = fopen(*(runs+j),"rb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",*(runs+j));
+   nerr++;
+   continue;
+  }
+  *(live+j)= partnext(*(fprun+j),head+j,body+j,bodysize+j);
+ }
+
+/***************************************************************
+
+ REPEATEDLY WRITE THE LOWEST CAST OF ALL RUNS, STARTING A NEW
+ PARTITION FILE WHENEVER THE PARTITION CHANGES
+
+****************************************************************/
+
+ fpout= NULL;
+ part= 0;
+
+ for ( ;; ) {
+
+  jmin= -1;
+  for ( j = 0; j < nruns; j++ ) {
+   if ( *(live+j) && ( jmin == -1 || partcmp(head+j,head+jmin) < 0 ) )
+    jmin= j;
+  }
+  if ( jmin == -1 ) break;
+
+  if ( fpout == NULL || (head+jmin)->part != part ) {
+
+   if ( fpout != NULL && fclose(fpout) != 0 ) nerr++;
+   part= (head+jmin)->part;
+   if ( partmode == 'M' ) snprintf(outname,maxname,"%s.%06d.csv",base,part);
+   else snprintf(outname,maxname,"%s.%04d.csv",base,part);
+
+   if ((fpout = fopen(outname,"w\0")) == NULL) {
+    printf("UNABLE TO OPEN FILE %s\n",outname);
+    nerr++;
+    break;
+   }
+   printheader(jchoice);
+
+  }
+
+  if ( fwrite(*(body+jmin),1,(head+jmin)->len,fpout) != (head+jmin)->len )
+   nerr++;
+  *(live+jmin)= partnext(*(fprun+jmin),head+jmin,body+jmin,bodysize+jmin);
+
+ }
+
+ if ( fpout != NULL && fclose(fpout) != 0 ) nerr++;
+
+/***************************************************************
+
+ REMOVE THE RUNS AND FREE THE MERGE BUFFERS, ALSO AFTER AN ERROR
+
+****************************************************************/
+
+ for ( j = 0; j < nruns; j++ ) {
+  if ( *(fprun+j) != NULL ) fclose(*(fprun+j));
+  remove(*(runs+j));
+  free(*(body+j));
+ }
+ free(fprun);
+ free(head);
+ free(body);
+ free(bodysize);
+ free(live);
+
+ return nerr;
+
+}
+
+/***************************************************************
+
+              FUNCTION PARTNEXT
+
+ PARTNEXT READS THE NEXT CAST RECORD OF A RUN FILE.  RETURNS ONE,
+ OR ZERO AT THE END OF THE RUN.
+
+***************************************************************/
+
+partnext(FILE *fprun, struct partrec *head, char **body, int *bodysize)
+
+{
+
+ if ( fread(head,sizeof(struct partrec),1,fprun) != 1 ) return 0;
+
+ if ( head->len > *bodysize ) {
+  *bodysize= head->len;
+  if ( (*body = realloc(*body,*bodysize)) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %d BYTES OF OUTPUT\n",
+    head->len);
+   return 0;
+  }
+ }
+
+ return fread(*body,1,head->len,fprun) == head->len;
+
+}
+
+/***************************************************************
+
+              FUNCTION IDXNAME
+
+ IDXNAME SETS THE NAME OF THE SPATIAL (KIND "sdx") OR TIME (KIND
+ "tdx") INDEX FILE FOR A WOD FILE, AND THE MAGIC STRING AT THE
+ START OF THAT INDEX FILE
+
+***************************************************************/
+
+idxname(char *name, char *magic, char *infile, char *kind)
+
+{
+
+ int j;
+
+ snprintf(name,maxname,"%s.%s",infile,kind);
+ strcpy(magic,"WOD");
+ for ( j = 0; j < 3; j++ ) *(magic+3+j)= toupper(*(kind+j));
+ strcpy(magic+6,"1");
+
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION ZORDER
+
+ ZORDER INTERLEAVES THE BITS OF 16 BIT LATITUDE (ODD BITS) AND
+ LONGITUDE (EVEN BITS) CELL NUMBERS INTO ONE Z-ORDER KEY, SO
+ THAT CASTS CLOSE TOGETHER ON THE GLOBE ARE MOSTLY CLOSE
+ TOGETHER IN THE SORTED INDEX
+
+***************************************************************/
+
+unsigned int zorder(unsigned int ilat, unsigned int ilon)
+
+{
+
+ unsigned int z=0;
+ int j;
+
+ for ( j = 0; j < 16; j++ ) {
+  z |= ( (ilon >> j) & 1u ) << (2*j);
+  z |= ( (ilat >> j) & 1u ) << (2*j+1);
+ }
+
+ return z;
+
+}
+
+/***************************************************************
+
+              FUNCTION ZCELL
+
+ ZCELL RETURNS THE 16 BIT CELL NUMBER OF A LATITUDE (KIND 'Y')
+ OR LONGITUDE (KIND 'X') GIVEN IN THOUSANDTHS OF A DEGREE
+
+***************************************************************/
+
+unsigned int zcell(int milli, int kind)
+
+{
+
+ long range= ( kind == 'Y' ) ? 180000L : 360000L;
+ long v= milli + range / 2;
+
+ if ( v < 0 ) v= 0;
+ if ( v > range ) v= range;
+ return (unsigned int)( v * 65535L / range );
+
+}
+
+/***************************************************************
+
+              FUNCTION BIGMIN
+
+ BIGMIN RETURNS THE SMALLEST Z-ORDER KEY GREATER THAN ZVAL WHICH
+ LIES INSIDE THE BOX WITH CORNER KEYS ZMIN AND ZMAX (TROPF AND
+ HERZOG), SO THE INDEX SEARCH CAN JUMP OVER KEYS OUTSIDE THE BOX
+
+***************************************************************/
+
+unsigned int bigmin(unsigned int zval, unsigned int zmin, unsigned int zmax)
+
+{
+
+ unsigned int big=0, mask, lower;
+ int bit, v, lo, hi;
+
+ for ( bit = 31; bit >= 0; bit-- ) {
+
+  mask= 1u << bit;
+  lower= ( (bit & 1) ? 0xAAAAAAAAu : 0x55555555u ) & ( mask - 1u );
+  v= ( zval & mask ) != 0;
+  lo= ( zmin & mask ) != 0;
+  hi= ( zmax & mask ) != 0;
+
+  if ( v == 0 && lo == 0 && hi == 1 ) {
+   big= ( zmin & ~lower ) | mask;
+   zmax= ( zmax & ~mask ) | lower;
+  }
+  else if ( v == 0 && lo == 1 && hi == 1 ) return zmin;
+  else if ( v == 1 && lo == 0 && hi == 0 ) return big;
+  else if ( v == 1 && lo == 0 && hi == 1 ) zmin= ( zmin & ~lower ) | mask;
+
+ }
+
+ return big;
+
+}
+
+/***************************************************************
+
+              FUNCTION BYZKEY
+
+ BYZKEY ORDERS INDEX ENTRIES BY Z-ORDER KEY, THEN FILE OFFSET
+ (FOR QSORT)
+
+***************************************************************/
+
+byzkey(const void *a, const void *b)
+
+{
+
+ const struct castidx *x= a, *y= b;
+
+ if ( x->zkey != y->zkey ) return ( x->zkey < y->zkey ) ? -1 : 1;
+ if ( x->offset != y->offset ) return ( x->offset < y->offset ) ? -1 : 1;
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION BUILDINDEX
+
+ BUILDINDEX WRITES THE SPATIAL INDEX FOR A WOD FILE: ONE ENTRY
+ PER CAST WITH POSITION, DATE, TIME AND BYTE OFFSET, SORTED BY
+ Z-ORDER KEY, AND THE TIME INDEX: ONE ENTRY PER BLOCK OF TBLOCK
+ CASTS.  ONLY THE CAST HEADERS ARE DECODED; THE REST OF EACH
+ CAST IS SKIPPED USING ITS BYTE COUNT.
+
+***************************************************************/
+
+buildindex(char *infile)
+
+{
+
+ struct idxhead head;
+ struct castidx *idx=NULL;
+ struct timeblk *blk=NULL, *b;
+ struct stat st;
+ char name[maxname], magic[8];
+ long n=0, nmax=0, nblk, j, t, tlo, thi;
+ float xlat, xlon;
+ int iend=0, oldhdr= hdronly;
+ FILE *fpidx;
+
+ if ( stat(infile,&st) != 0 || (fp = fopen(infile,"rb\0")) == NULL ) {
+  printf("UNABLE TO OPEN FILE %s\n",infile);
+  return -1;
+ }
+
+/***************************************************************
+ SAVE THE CALLER'S HEADER MODE: -inv AND -w BUILD THE INDEX FROM
+ SELECTCASTS AND MUST STILL DECODE ONLY HEADERS AFTERWARD
+***************************************************************/
+
+ hdronly= 1;
+ filesize= st.st_size;
+
+ while ( !feof(fp) ) {
+
+  if ( ( iend = oclread() ) == -1 ) break;
+  if ( iend == 2 ) continue;
+
+  if ( n >= nmax ) {
+   nmax= ( nmax == 0 ) ? 4096 : 2 * nmax;
+   if ( (idx = realloc(idx,nmax * sizeof(struct castidx))) == NULL ) {
+    printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld INDEX ENTRIES\n",nmax);
+    hdronly= oldhdr;
+    fclose(fp);
+    return -1;
+   }
+  }
+
+  xlat= (latitude/ tenp[ *(hrightfig+1) ]);
+  xlon= (longitude/ tenp[ *(hrightfig+2) ]);
+
+  (idx+n)->lat= ( xlat >= 0. ) ? xlat * 1000. + 0.5 : xlat * 1000. - 0.5;
+  (idx+n)->lon= ( xlon >= 0. ) ? xlon * 1000. + 0.5 : xlon * 1000. - 0.5;
+  (idx+n)->zkey= zorder(zcell((idx+n)->lat,'Y'),zcell((idx+n)->lon,'X'));
+  (idx+n)->date= year * 10000 + month * 100 + day;
+  (idx+n)->hour= hourkey();
+  (idx+n)->id= ostation;
+  (idx+n)->offset= castoffset;
+  n++;
+
+ }
+
+ hdronly= oldhdr;
+ fclose(fp);
+
+/***************************************************************
+
+ TIME INDEX: EARLIEST AND LATEST TIME OF EACH BLOCK OF CASTS, IN
+ FILE ORDER (A CAST WITHOUT AN HOUR COVERS THE WHOLE DAY)
+
+****************************************************************/
+
+ nblk= ( n + tblock - 1 ) / tblock;
+ if ( (blk = calloc(nblk+1,sizeof(struct timeblk))) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld INDEX ENTRIES\n",nblk);
+  free(idx);
+  return -1;
+ }
+
+ for ( j = 0; j < n; j++ ) {
+
+  b= blk + j / tblock;
+  t= (idx+j)->date * 100L;
+  tlo= t + ( (idx+j)->hour < 0 ? 0 : (idx+j)->hour / 100 );
+  thi= t + ( (idx+j)->hour < 0 ? 23 : (idx+j)->hour / 100 );
+
+  if ( b->ncast == 0 ) {
+   b->offset= (idx+j)->offset;
+   b->tmin= tlo;
+   b->tmax= thi;
+  }
+  if ( tlo < b->tmin ) b->tmin= tlo;
+  if ( thi > b->tmax ) b->tmax= thi;
+  b->ncast++;
+
+ }
+
+ qsort(idx,n,sizeof(struct castidx),byzkey);
+
+ memset(&head,0,sizeof(head));
+ head.fsize= st.st_size;
+ head.mtime= st.st_mtime;
+
+ for ( j = 0; j < 2; j++ ) {
+
+  idxname(name,magic,infile,( j == 0 ) ? "sdx" : "tdx");
+  strcpy(head.magic,magic);
+  head.ncast= ( j == 0 ) ? n : nblk;
+
+  if ((fpidx = fopen(name,"wb\0")) == NULL) {
+   printf("UNABLE TO OPEN FILE %s\n",name);
+   free(idx);
+   free(blk);
+   return -1;
+  }
+
+  fwrite(&head,sizeof(head),1,fpidx);
+  if ( j == 0 ) fwrite(idx,sizeof(struct castidx),n,fpidx);
+  else fwrite(blk,sizeof(struct timeblk),nblk,fpidx);
+
+  if ( fclose(fpidx) != 0 ) {
+   printf("UNABLE TO WRITE FILE %s\n",name);
+   free(idx);
+   free(blk);
+   return -1;
+  }
+
+ }
+
+ free(idx);
+ free(blk);
+ return 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION LOADINDEX
+
+ LOADINDEX READS THE SPATIAL (KIND "sdx") OR TIME (KIND "tdx")
+ INDEX OF A WOD FILE, BUILDING BOTH FIRST IF IT DOES NOT EXIST OR
+ THE WOD FILE HAS CHANGED SINCE.  RETURNS THE NUMBER OF ENTRIES,
+ OR -1.
+
+***************************************************************/
+
+long loadindex(char *infile, char *kind, void **idx)
+
+{
+
+ struct idxhead head;
+ struct stat st;
+ char name[maxname], magic[8];
+ size_t size;
+ FILE *fpidx;
+ int ntry;
+
+ if ( stat(infile,&st) != 0 ) {
+  printf("UNABLE TO OPEN FILE %s\n",infile);
+  return -1;
+ }
+
+ idxname(name,magic,infile,kind);
+ size= ( *kind == 's' ) ? sizeof(struct castidx) : sizeof(struct timeblk);
+
+ for ( ntry = 0; ntry < 2; ntry++ ) {
+
+  if ( (fpidx = fopen(name,"rb\0")) != NULL ) {
+
+   if ( fread(&head,sizeof(head),1,fpidx) == 1 &&
+        strcmp(head.magic,magic) == 0 &&
+        head.fsize == st.st_size && head.mtime == st.st_mtime ) {
+
+    if ( (*idx = malloc((head.ncast+1) * size)) == NULL ) {
+     printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld INDEX ENTRIES\n",
+      head.ncast);
+     fclose(fpidx);
+     return -1;
+    }
+
+    if ( fread(*idx,size,head.ncast,fpidx) == head.ncast ) {
+     fclose(fpidx);
+     return head.ncast;
+    }
+
+    free(*idx);
+
+   }
+
+   fclose(fpidx);
+
+  }
+
+  if ( ntry == 0 && buildindex(infile) != 0 ) return -1;
+
+ }
+
+ printf("UNABLE TO READ INDEX %s\n",name);
+ return -1;
+
+}
+
+/***************************************************************
+
+              FUNCTION BOXSEARCH
+
+ BOXSEARCH ADDS THE OFFSET OF EVERY CAST IN THE SORTED INDEX
+ INSIDE THE BOX LAT1-LAT2, LON1-LON2 (THOUSANDTHS OF A DEGREE)
+ TO SEL.  IF QKM IS POSITIVE, ONLY CASTS WITHIN QKM KILOMETERS
+ OF THE QUERY CENTER ARE ADDED, AND WITH A TIME QUERY ONLY CASTS
+ IN THE TIME WINDOW.  RETURNS THE NEW NUMBER OF CASTS IN SEL.
+
+***************************************************************/
+
+long boxsearch(struct castidx *idx, long n, int lat1, int lat2, int lon1,
+               int lon2, struct castspan *sel, long nsel)
+
+{
+
+ unsigned int zmin, zmax, znext, ylo, yhi, xlo, xhi, y, x;
+ long lo, hi, mid, k;
+ int j;
+
+ ylo= zcell(lat1,'Y');
+ yhi= zcell(lat2,'Y');
+ xlo= zcell(lon1,'X');
+ xhi= zcell(lon2,'X');
+ zmin= zorder(ylo,xlo);
+ zmax= zorder(yhi,xhi);
+
+/***************************************************************
+
+ FIND THE FIRST ENTRY AT OR PAST ZMIN, THEN WALK UP TO ZMAX,
+ JUMPING TO THE NEXT KEY BACK INSIDE THE BOX (BIGMIN) WHENEVER
+ THE WALK LEAVES IT
+
+****************************************************************/
+
+ lo= 0;
+ hi= n;
+ while ( lo < hi ) {
+  mid= ( lo + hi ) / 2;
+  if ( (idx+mid)->zkey < zmin ) lo= mid+1;
+  else hi= mid;
+ }
+
+ k= lo;
+ while ( k < n && (idx+k)->zkey <= zmax ) {
+
+  for ( y= 0, x= 0, j = 0; j < 16; j++ ) {
+   x |= ( ( (idx+k)->zkey >> (2*j) ) & 1u ) << j;
+   y |= ( ( (idx+k)->zkey >> (2*j+1) ) & 1u ) << j;
+  }
+
+  if ( y < ylo || y > yhi || x < xlo || x > xhi ) {
+
+   znext= bigmin((idx+k)->zkey,zmin,zmax);
+   lo= k;
+   hi= n;
+   while ( lo < hi ) {
+    mid= ( lo + hi ) / 2;
+    if ( (idx+mid)->zkey < znext ) lo= mid+1;
+    else hi= mid;
+   }
+   k= lo;
+   continue;
+
+  }
+
+  if ( (idx+k)->lat >= lat1 && (idx+k)->lat <= lat2 &&
+       (idx+k)->lon >= lon1 && (idx+k)->lon <= lon2 &&
+       ( qkm <= 0. || distkm((idx+k)->lat,(idx+k)->lon) <= qkm ) &&
+       ( tquery == 0 || intime((idx+k)->date,(idx+k)->hour) ) ) {
+   (sel+nsel)->offset= (idx+k)->offset;
+   (sel+nsel++)->ncast= 1;
+  }
+
+  k++;
+
+ }
+
+ return nsel;
+
+}
+
+/***************************************************************
+
+              FUNCTION DISTKM
+
+ DISTKM RETURNS THE GREAT CIRCLE DISTANCE IN KILOMETERS FROM THE
+ QUERY CENTER TO A POSITION IN THOUSANDTHS OF A DEGREE
+
+***************************************************************/
+
+double distkm(int lat, int lon)
+
+{
+
+ double rad= 3.14159265358979 / 180., a, dlat, dlon;
+
+ dlat= ( lat / 1000. - qlat0 ) * rad;
+ dlon= ( lon / 1000. - qlon0 ) * rad;
+ a= sin(dlat/2.) * sin(dlat/2.) +
+    cos(qlat0 * rad) * cos(lat / 1000. * rad) * sin(dlon/2.) * sin(dlon/2.);
+
+ return 2. * 6371.0 * asin( sqrt(a) < 1. ? sqrt(a) : 1. );
+
+}
+
+/***************************************************************
+
+              FUNCTION BYOFFSET
+
+ BYOFFSET ORDERS SELECTED CASTS BY FILE OFFSET (FOR QSORT)
+
+***************************************************************/
+
+byoffset(const void *a, const void *b)
+
+{
+
+ long x= ((const struct castspan *)a)->offset;
+ long y= ((const struct castspan *)b)->offset;
+
+ return ( x < y ) ? -1 : ( x > y );
+
+}
+
+/***************************************************************
+
+              FUNCTION SELECTCASTS
+
+ SELECTCASTS RETURNS IN SEL THE CASTS, IN FILE ORDER, MATCHING
+ THE BOX (-box) OR RADIUS (-r) QUERY USING THE SPATIAL INDEX, OR
+ THE BLOCKS OF CASTS WHICH MAY MATCH THE TIME QUERY (-t) USING
+ THE TIME INDEX.  RETURNS THE NUMBER OF ENTRIES IN SEL, OR -1.
+
+***************************************************************/
+
+long selectcasts(char *infile, struct castspan **sel)
+
+{
+
+ struct castidx *idx;
+ struct timeblk *blk;
+ long n, nsel=0;
+ int lat1, lat2, lon1, lon2;
+ double dlat, dlon;
+
+ if ( squery == 0 ) {
+
+  if ( (n = loadindex(infile,"tdx",(void **)&blk)) < 0 ) return -1;
+  if ( (*sel = malloc((n+1) * sizeof(struct castspan))) == NULL ) {
+   printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld CASTS\n",n);
+   free(blk);
+   return -1;
+  }
+
+  nsel= timesearch(blk,n,*sel);
+  free(blk);
+  return nsel;
+
+ }
+
+ if ( (n = loadindex(infile,"sdx",(void **)&idx)) < 0 ) return -1;
+
+ if ( (*sel = malloc((n+1) * sizeof(struct castspan))) == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld CASTS\n",n);
+  free(idx);
+  return -1;
+ }
+
+/***************************************************************
+
+ A RADIUS QUERY SEARCHES THE BOX AROUND ITS CIRCLE
+
+****************************************************************/
+
+ if ( qkm > 0. ) {
+
+  dlat= qkm / 111.195;
+  qlat1= qlat0 - dlat;
+  qlat2= qlat0 + dlat;
+  if ( qlat1 < -90. ) qlat1= -90.;
+  if ( qlat2 > 90. ) qlat2= 90.;
+
+  if ( qlat1 <= -89.9 || qlat2 >= 89.9 ||
+       ( dlon = dlat / cos(qlat0 * 3.14159265358979 / 180.) ) >= 180. ) {
+   qlon1= -180.;
+   qlon2= 180.;
+  }
+  else {
+   qlon1= qlon0 - dlon;
+   qlon2= qlon0 + dlon;
+   if ( qlon1 < -180. ) qlon1 += 360.;
+   if ( qlon2 > 180. ) qlon2 -= 360.;
+  }
+
+ }
+
+ lat1= qlat1 * 1000. + ( qlat1 >= 0. ? 0.5 : -0.5 );
+ lat2= qlat2 * 1000. + ( qlat2 >= 0. ? 0.5 : -0.5 );
+ lon1= qlon1 * 1000. + ( qlon1 >= 0. ? 0.5 : -0.5 );
+ lon2= qlon2 * 1000. + ( qlon2 >= 0. ? 0.5 : -0.5 );
+
+/***************************************************************
+
+ A BOX CROSSING THE DATE LINE (LON1 EAST OF LON2) IS SEARCHED
+ AS TWO BOXES
+
+****************************************************************/
+
+ if ( lon1 <= lon2 )
+  nsel= boxsearch(idx,n,lat1,lat2,lon1,lon2,*sel,nsel);
+ else {
+  nsel= boxsearch(idx,n,lat1,lat2,lon1,180000,*sel,nsel);
+  nsel= boxsearch(idx,n,lat1,lat2,-180000,lon2,*sel,nsel);
+ }
+
+ free(idx);
+ qsort(*sel,nsel,sizeof(struct castspan),byoffset);
+
+ return nsel;
+
+}
+
+/***************************************************************
+
+              FUNCTION TIMESEARCH
+
+ TIMESEARCH ADDS TO SEL EVERY BLOCK OF THE TIME INDEX WHOSE TIME
+ RANGE OVERLAPS THE QUERY WINDOW.  CASTS ARE NEARLY IN TIME ORDER,
+ SO THE LATEST TIME SO FAR RISES AND THE EARLIEST TIME TO COME
+ FALLS THROUGH THE FILE; BINARY SEARCHES ON THESE FIND THE FIRST
+ AND LAST BLOCKS WHICH CAN OVERLAP, AND ONLY THE BLOCKS BETWEEN
+ ARE CHECKED.  RETURNS THE NUMBER OF BLOCKS IN SEL.
+
+***************************************************************/
+
+long timesearch(struct timeblk *blk, long n, struct castspan *sel)
+
+{
+
+ long *runmax, *runmin, lo, hi, mid, j, jfirst, jlast, jprev=-2, nsel=0;
+
+ runmax= malloc((n+1) * sizeof(long));
+ runmin= malloc((n+1) * sizeof(long));
+ if ( runmax == NULL || runmin == NULL ) {
+  printf(" NOT ENOUGH SPACE IN MEMORY FOR %ld INDEX ENTRIES\n",n);
+  free(runmax);
+  free(runmin);
+  return 0;
+ }
+
+ for ( j = 0; j < n; j++ )
+  *(runmax+j)= ( j == 0 || (blk+j)->tmax > *(runmax+j-1) ) ?
+                (blk+j)->tmax : *(runmax+j-1);
+ for ( j = n-1; j >= 0; j-- )
+  *(runmin+j)= ( j == n-1 || (blk+j)->tmin < *(runmin+j+1) ) ?
+                (blk+j)->tmin : *(runmin+j+1);
+
+/***************************************************************
+
+ FIRST BLOCK WHOSE LATEST TIME SO FAR REACHES THE WINDOW, LAST
+ BLOCK WHOSE EARLIEST TIME TO COME IS NOT PAST THE WINDOW
+
+****************************************************************/
+
+ lo= 0;
+ hi= n;
+ while ( lo < hi ) {
+  mid= ( lo + hi ) / 2;
+  if ( *(runmax+mid) < tfrom ) lo= mid+1;
+  else hi= mid;
+ }
+ jfirst= lo;
+
+ lo= 0;
+ hi= n;
+ while ( lo < hi ) {
+  mid= ( lo + hi ) / 2;
+  if ( *(runmin+mid) <= tto ) lo= mid+1;
+  else hi= mid;
+ }
+ jlast= lo - 1;
+
+ for ( j = jfirst; j <= jlast; j++ ) {
+
+  if ( (blk+j)->tmax < tfrom || (blk+j)->tmin > tto ) continue;
+
+/***************************************************************
+
+ CONSECUTIVE BLOCKS ARE READ AS ONE SPAN
+
+****************************************************************/
+
+  if ( j == jprev + 1 ) (sel+nsel-1)->ncast += (blk+j)->ncast;
+  else {
+   (sel+nsel)->offset= (blk+j)->offset;
+   (sel+nsel++)->ncast= (blk+j)->ncast;
+  }
+  jprev= j;
+
+ }
+
+ free(runmax);
+ free(runmin);
+ return nsel;
+
+}
+
+/***************************************************************
+
+              FUNCTION TIMEKEY
+
+ TIMEKEY CONVERTS A TIME GIVEN AS YYYY, YYYYMM, YYYYMMDD OR
+ YYYYMMDDHH TO YYYYMMDDHH, FILLING MISSING FIELDS WITH THE
+ START (LAST= 0) OR END (LAST= 1) OF THE PERIOD GIVEN
+
+***************************************************************/
+
+long timekey(char *s, int last)
+
+{
+
+ long t= atol(s);
+ int n= strlen(s);
+
+ if ( n <= 4 ) t= t * 100 + ( last ? 12 : 1 );
+ if ( n <= 6 ) t= t * 100 + ( last ? 31 : 1 );
+ if ( n <= 8 ) t= t * 100 + ( last ? 23 : 0 );
+
+ return t;
+
+}
+
+/***************************************************************
+
+              FUNCTION HOURKEY
+
+ HOURKEY RETURNS THE HOUR OF THE PRESENT CAST IN HUNDREDTHS, OR
+ -1 IF NO VALID HOUR WAS GIVEN
+
+***************************************************************/
+
+hourkey()
+
+{
+
+ float xhour= (hour/ tenp[ *(hrightfig) ]);
+
+ if ( xhour >= 0.0 && xhour <= 24.0 ) return xhour * 100. + 0.5;
+ return -1;
+
+}
+
+/***************************************************************
+
+              FUNCTION INTIME
+
+ INTIME RETURNS ONE IF A CAST AT DATE (YYYYMMDD) AND HOUR (IN
+ HUNDREDTHS, NEGATIVE IF NOT GIVEN) IS IN THE QUERY WINDOW.  A
+ CAST WITHOUT AN HOUR MATCHES IF ITS DAY IS IN THE WINDOW.
+
+***************************************************************/
+
+intime(int date, int hour)
+
+{
+
+ if ( hour < 0 )
+  return ( date * 100L + 23 >= tfrom && date * 100L <= tto );
+
+ return ( date * 100L + hour / 100 >= tfrom &&
+          date * 100L + hour / 100 <= tto );
+
+}
+
+oclread()
+
+{
+
+ int i,j;
+
+ char wodform;
+ int totfig=0, sigfig=0, rightfig=0;
+ int nbytet,ntypec,nbytec,nbytes,nbyteb;
+ int ninfc,ntoff, doff;
+ int missing=-9999;
+ int npinfs=0,npinfe=0,npinf;
+ int iend=0, readz, vpos=-1;
+ double t0=0., tin=0., t;
+
+/**********************************************************
+
+ READ IN WOD FORMAT CODE: 'C' FOR WOD13 FORMAT
+ 'B' FOR WOD05/WOD09 FORMAT
+ 'A' FOR WOD01 FORMAT
+ THE THREE ARE LAID OUT ALIKE, EXCEPT THAT STANDARD LEVEL CASTS
+ IN 'A' AND 'B' HAVE NO DEPTHS (SEE BELOW)
+
+***********************************************************/
+
+ castoffset= ftell(fp);
+ castbytes= 0;
+ if ( statmode == 1 ) {
+  t0= seconds();
+  tin= runstats.tinput;
+ }
+ totfig= 1;
+ if ( (iend = extractc(0,&totfig,&wodform)) == -1 ) return iend;
+
+ ostation= 0;
+ if ( wodform != 'C' && wodform != 'B' && wodform != 'A' )
+  return badcast("NO WOD01, WOD05, WOD09 OR WOD13 FORMAT CODE");
+
+/**********************************************************
+
+ READ IN NUMBER OF BYTES IN ASCII CAST 
+
+***********************************************************/
+
+ if ( ( iend = extracti(0,&totfig,&sigfig,&rightfig,&nbytet,missing))
+          == -1 ) return iend;
+
+/**********************************************************
+
+ A BYTE COUNT TOO SMALL TO HOLD A CAST HEADER, OR RUNNING PAST
+ THE END OF THE FILE, CANNOT BE RIGHT
+
+***********************************************************/
+
+ if ( totfig < 1 || nbytet < 20 )
+  return badcast("BYTE COUNT MISSING OR TOO SMALL");
+ if ( filesize > 0 && castoffset + nbytet > filesize )
+  return badcast("BYTE COUNT RUNS PAST THE END OF THE FILE");
+
+/**********************************************************
+
+ READ IN WOD CAST NUMBER
+
+***********************************************************/
+
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&ostation,missing))
+       == -1 ) return iend;
+
+/**********************************************************
+
+ SKIP THE REST OF THE CAST IF IT HAS ALREADY BEEN CONVERTED.  IT
+ IS ONLY MARKED AS CONVERTED ONCE IT HAS BEEN READ WHOLE AND FOUND
+ GOOD (CONVERTFILE), SO A BAD COPY DOES NOT HIDE A GOOD ONE
+
+***********************************************************/
+
+ if ( dedup == 1 && hdronly != 1 && seenbefore(ostation) ) {
+  nduplicate++;
+  return skipcast(nbytet);
+ }
+
+/*********************************************************
+
+ READ IN NODC COUNTRY CODE
+
+**********************************************************/
+
+ totfig= 2;
+ if ( (iend = extractc(0,&totfig,cc)) == -1 ) return iend;
+
+/**********************************************************
+
+ READ IN CRUISE NUMBER
+
+***********************************************************/
+
+ if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&icruise,
+             missing)) == -1) return iend;
+
+/**********************************************************
+
+ SKIP THE REST OF THE CAST IF IT IS NOT IN THE WOD UNIQUE NUMBER
+ OR CRUISE LISTS
+
+***********************************************************/
+
+ if ( ( nidlist > 0 || ncruise > 0 ) && hdronly != 1 && !castselect() )
+  return skipcast(nbytet);
+
+/**********************************************************
+
+ READ IN YEAR, MONTH, DAY, TIME
+
+***********************************************************/
+
+ totfig=4;
+ if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&year,missing))
+       == -1) return iend;
+ totfig=2;
+ if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&month,missing))
        == -1) return iend;
  totfig=2;
  if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&day,missing))
@@ -449,6 +4481,16 @@ oclread()
  if ( (iend = extracti(1,htotfig,hsigfig,hrightfig,
               &hour, 9999)) == -1) return iend;
 
+/**********************************************************
+
+ SKIP THE REST OF THE CAST IF IT IS OUTSIDE THE TIME WINDOW
+
+***********************************************************/
+
+ if ( tquery == 1 && hdronly != 1 &&
+      !intime(year * 10000 + month * 100 + day,hourkey()) )
+  return skipcast(nbytet);
+
 /**********************************************************
 
  READ IN LATITUDE AND LONGITUDE
@@ -461,6 +4503,18 @@ oclread()
  if ( (iend = extracti(1,(htotfig+2),(hsigfig+2),(hrightfig+2),
               &longitude, -99999)) == -1) return iend;
 
+ if ( hdronly == 1 ) return skipcast(nbytet);
+
+/**********************************************************
+
+ MAKE ROOM FOR THE LARGEST CAST THAT COULD FIT IN NBYTET BYTES
+ (A DEPTH WITH ITS FLAGS TAKES AT LEAST SIX BYTES, A MEASURED
+ VALUE AT LEAST ONE), SO NO SPACE IS NEEDED PART WAY THROUGH
+
+***********************************************************/
+
+ if ( nbytet <= maxcast ) spacerfit(nbytet/6+1,nbytet);
+
 /**********************************************************
 
  READ IN NUMBER OF LEVELS
@@ -514,6 +4568,8 @@ oclread()
   if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&npinf,missing))
        == -1 ) return iend;
   npinfe += npinf;
+  if ( npinf < 0 || npinfe > maxpsec )
+   return badcast("TOO MANY VARIABLE SPECIFIC SECOND HEADERS");
 
 /*******************************************************************
 
@@ -537,6 +4593,32 @@ oclread()
 
  npsec = npinfe;
 
+/**********************************************************
+
+ SKIP THE REST OF THE CAST IF IT DOES NOT HAVE THE VARIABLE
+ REQUESTED, OR NO VARIABLE WITH AN ACCEPTED PROFILE
+
+***********************************************************/
+
+ for ( i = 0; i < nparm; i++ ) {
+  *(profok+i)= qcok(qcp,*(iperror+i));
+  if ( *(ip2+i) == vchoice && *(profok+i) ) vpos= i;
+ }
+
+ if ( ( vchoice > 0 || qcmode == 1 ) && hdronly != 1 ) {
+  for ( i = 0; i < nparm; i++ )
+   if ( *(profok+i) && ( vchoice == 0 || *(ip2+i) == vchoice ) ) break;
+  if ( i == nparm ) return skipcast(nbytet);
+ }
+
+/**********************************************************
+
+ FOR THE INVENTORY THE HEADER IS ALL THAT IS NEEDED
+
+***********************************************************/
+
+ if ( hdronly == 2 ) return ( skipcast(nbytet) == -1 ) ? -1 : 0;
+
 /***************************************************************
 
  READ IN NUMBER OF BYTES IN CHARACTER AND PRIMARY INVESTIGATOR FIELDS
@@ -545,11 +4627,14 @@ oclread()
 
  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nbytec,
              missing)) == -1) return iend;
+ if ( nbytec > nbytet ) return badcast("BLOCK BYTE COUNT LARGER THAN CAST");
 
 /**********************************************************
 
  READ IN NUMBER OF INFORMATION TYPES (MAX 3: FOR CRUISE CODE,
- STATION CODE AND PI INFORMATION)
+ STATION CODE AND PI INFORMATION).  WHEN THESE, THE SECONDARY
+ HEADERS OR THE BIOLOGY ARE NOT NEEDED, EACH BLOCK IS SKIPPED
+ WHOLE USING ITS BYTE COUNT.
 
 ***********************************************************/
 
@@ -557,7 +4642,13 @@ oclread()
  origsfig= 0;
  npi= 0;
 
- if ( nbytec > 0 ) {
+ if ( nbytec > 0 && piinfo == 0 ) {
+
+  if ( (iend = skipbytes(nbytec)) == -1 ) return iend;
+
+ }
+
+ else if ( nbytec > 0 ) {
 
   totfig=1;
   if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&ninfc,missing))
@@ -587,6 +4678,7 @@ oclread()
     totfig=2;
     if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&origcfig,
      missing)) == -1) return iend;
+    if ( origcfig >= 30 ) return badcast("CRUISE CODE TOO LONG");
     if ( (iend = extractc(0,&origcfig,origc)) == -1 ) return iend;
 
    }
@@ -602,6 +4694,7 @@ oclread()
     totfig=2;
     if ( (iend = extracti(2,&totfig,&sigfig,&rightfig,&origsfig,
      missing)) == -1) return iend;
+    if ( origsfig >= 30 ) return badcast("STATION CODE TOO LONG");
     if ( (iend = extractc(0,&origsfig,origs)) == -1 ) return iend;
 
    }
@@ -654,9 +4747,16 @@ oclread()
 
  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nbytes,
              missing)) == -1) return iend;
+ if ( nbytes > nbytet ) return badcast("BLOCK BYTE COUNT LARGER THAN CAST");
 
  nsec = 0;
- if ( nbytes > 0 ) {
+ if ( nbytes > 0 && secinfo == 0 ) {
+
+  if ( (iend = skipbytes(nbytes)) == -1 ) return iend;
+
+ }
+
+ else if ( nbytes > 0 ) {
 
 /**************************************************************
 
@@ -666,6 +4766,7 @@ oclread()
 
   if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nsec,
               missing)) == -1) return iend;
+  if ( nsec > maxsec ) return badcast("TOO MANY SECOND HEADERS");
 
 /**********************************************************
 
@@ -692,10 +4793,18 @@ oclread()
 
  if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nbyteb,
              missing)) == -1) return iend;
+ if ( nbyteb > nbytet ) return badcast("BLOCK BYTE COUNT LARGER THAN CAST");
 
  nbio= 0;
  ntsets= 0;
- if ( nbyteb > 0 ) {
+
+ if ( nbyteb > 0 && biology == 0 ) {
+
+  if ( (iend = skipbytes(nbyteb)) == -1 ) return iend;
+
+ }
+
+ else if ( nbyteb > 0 ) {
 
 /**************************************************************
 
@@ -705,6 +4814,7 @@ oclread()
 
   if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&nbio,
               missing)) == -1) return iend;
+  if ( nbio > maxbio ) return badcast("TOO MANY BIOLOGY HEADERS");
 
 /**********************************************************
 
@@ -729,20 +4839,17 @@ oclread()
 
   if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,&ntsets,
              missing)) == -1) return iend;
+  if ( ntsets > nbyteb ) return badcast("TOO MANY TAXA SETS");
 
 /***************************************************************
 
- IF NUMBER OF TAXA SETS IS GREATER THAN THE PREVIOUS MAXIMUM,
- REALLOCATE SPACE ACCORDINGLY
+ MAKE ROOM FOR THE TAXA SETS, AND FOR AS MANY ENTRIES AS COULD
+ FIT IN NBYTEB BYTES (EACH TAKES AT LEAST EIGHT)
 
 ****************************************************************/
 
-  if ( ntsets > ntsetsmax ) {
-
-   ntsetsmax= ntsets;
-   spacer(2);
-
-  }
+  taxfit(ntsets,nbyteb/8+1);
+  *ntstart= 0;
 
   if ( ntsets > 0 ) {
 
@@ -758,7 +4865,11 @@ oclread()
     if ( (iend = extracti(0,&totfig,&sigfig,&rightfig,(ntloc+j),
                missing)) == -1) return iend;
 
-    ntoff= maxtax * j;
+    ntoff= *(ntstart+j);
+    *(ntstart+j+1)= ntoff + *(ntloc+j);
+    if ( *(ntloc+j) < 0 || *(ntstart+j+1) > nbyteb )
+     return badcast("TOO MANY TAXA SET ENTRIES");
+    taxfit(ntsets,*(ntstart+j+1));
 
 /**********************************************************
 
@@ -791,43 +4902,95 @@ oclread()
 
 /***************************************************************
 
- IF NUMBER OF DEPTHS IS GREATER THAN THE PREVIOUS MAXIMUM,
-  REALLOCATE SPACE ACCORDINGLY
+ MAKE SURE THE DEPTHS AND MEASURED VALUES FIT (ONLY A CAST WHOSE
+ COUNTS DISAGREE WITH NBYTET CAN NEED MORE SPACE HERE)
 
 ****************************************************************/
 
+ if ( levels < 0 || nparm < 0 || levels > nbytet ||
+      (double) levels * nparm > nbytet )
+  return badcast("LEVEL COUNTS DO NOT FIT BYTE COUNT");
  zsize= levels;
- if ( zsize > zsizemax ) {
+ isize= nparm * levels;
+ spacerfit(zsize,isize);
 
-  zsizemax=zsize;
-  spacer(3);
+/**********************************************************
+
+ HEADER DECODE TIME, LESS TIME SPENT WAITING FOR INPUT
+
+***********************************************************/
 
+ if ( statmode == 1 ) {
+  t= seconds();
+  statadd(0,t-t0-(runstats.tinput-tin));
+  t0= t;
+  tin= runstats.tinput;
+  runstats.nlevel += levels;
+  runstats.nvalue += nparm * levels;
  }
 
-/***************************************************************
+/**********************************************************
 
- IF NUMBER OF DEPTHS MULTIPLIED BY NUMBER OF VARIABLES IS
- GREATER THAN THE PREVIOUS MAXIMUM, REALLOCATE SPACE ACCORDINGLY
+ STANDARD LEVEL CASTS IN THE OLDER FORMATS CARRY NO DEPTHS:
+ LEVEL J IS AT STANDARD DEPTH J (WHOLE METRES, NO FLAGS).
+ ANY LEVEL BEYOND THE LAST STANDARD DEPTH IS GIVEN A MISSING DEPTH.
 
-****************************************************************/
+***********************************************************/
 
- isize= nparm * levels;
- if ( isize > isizemax ) {
+ readz= ( isoor == 0 || wodform == 'C' );
+
+ if ( readz == 0 ) {
+
+  for ( j = 0; j < levels; j++ ) {
+
+   *(depth+j)= ( j < nodepth ) ? *(odepth+j) : missing;
+   *(zrightfig+j)= 0;
+   *(ztotfig+j)= ( j >= nodepth ) ? 0 : ( *(depth+j) < 10 ) ? 1 :
+                 ( *(depth+j) < 100 ) ? 2 : ( *(depth+j) < 1000 ) ? 3 : 4;
+   *(zsigfig+j)= *(ztotfig+j);
+   *(zerr+j)= 0;
+   *(zoerr+j)= 0;
+
+  }
+
+ }
+
+/**********************************************************
+
+ BOTTOM MODE, WHEN THE LAST LEVEL IS ALWAYS THE ONE WRITTEN (ALL
+ VARIABLES, NO QUALITY CONTROL): STEP OVER EVERY OTHER LEVEL BY
+ ITS FIGURE COUNTS AND DECODE THE LAST ONE ONLY, AS A ONE LEVEL
+ CAST.
+
+***********************************************************/
+
+ if ( *xchoice == 'B' && vchoice == 0 && qcmode == 0 && levels > 1 ) {
+
+  for ( j = 0; j < levels - 1; j++ ) {
+   if ( readz && skipvalue(1) == -1 ) return -1;
+   for ( i = 0; i < nparm; i++ ) if ( skipvalue(0) == -1 ) return -1;
+  }
 
-  isizemax=isize;
-  spacer(4);
+  *depth= *(depth+j);
+  *zrightfig= *(zrightfig+j);
+  *ztotfig= *(ztotfig+j);
+  *zsigfig= *(zsigfig+j);
+  levels= 1;
 
  }
 
 /**********************************************************
 
- READ IN EACH DEPTH VALUE, ERROR FLAG, AND ORIGINATORS FLAG
+ READ IN EACH DEPTH VALUE, ERROR FLAG, AND ORIGINATORS FLAG.
+ IN INTERVAL MODE STOP AT THE FIRST LEVEL BELOW THE INTERVAL
+ (CASTS ARE ORDERED BY DEPTH), IN SURFACE MODE AFTER THE FIRST
+ LEVEL TO BE WRITTEN, AND SKIP THE REST OF THE CAST.
 
 ***********************************************************/
 
  for ( j = 0; j < levels; j++ ) {
 
-  if ( isoor == 0 || wodform == 'C' ) {
+  if ( readz ) {
 
    if ( (iend = extracti(1,(ztotfig+j),(zsigfig+j),
                (zrightfig+j), (depth+j), missing))
@@ -841,6 +5004,9 @@ oclread()
 
   }
 
+  if ( *xchoice == 'I' &&
+       (float) (*(depth+j)/ tenp[*(zrightfig+j)]) > xinterv2 ) break;
+
 /**********************************************************
 
  READ IN EACH DATA VALUE
@@ -871,12 +5037,18 @@ oclread()
     *(derr+doff+j)=0;
     *(doerr+doff+j)=0;
     *(drightfig+doff+j)=2;
+    runstats.nmissing++;
 
    }
 
 
   }
 
+  if ( *xchoice == 'S' && levelout(j,vpos) ) {
+   j++;
+   break;
+  }
+
  }
 
 /***********************************************************
@@ -885,7 +5057,22 @@ oclread()
 
 ************************************************************/
 
- while ( ( i = fgetc(fp)) != '\n' && !feof(fp) );
+ nzread= j;
+
+/***********************************************************
+
+ A FULLY DECODED CAST MUST HAVE TAKEN EXACTLY NBYTET BYTES
+
+************************************************************/
+
+ if ( nzread == levels && castbytes != nbytet )
+  return badcast("BYTES DECODED DO NOT MATCH BYTE COUNT");
+
+ if ( nzread < levels ) {
+  if ( skipcast(nbytet) == -1 ) return -1;
+ }
+ else while ( ( i = fgetc(fp)) != '\n' && !feof(fp) );
+ if ( statmode == 1 ) statadd(1,seconds()-t0-(runstats.tinput-tin));
  return iend;
 
 }
@@ -904,17 +5091,25 @@ printheader( int jchoice )
 
  int k;
 
+ if ( subsetmode == 1 ) return 0;
+
  fprintf(fpout,"ISO_country,Cruise_ID,Latitude,Longitude,Year,Month,Day,");
+ if ( invmode == 1 ) {
+  fprintf(fpout,"Time,WOD_unique,Levels,Standard_levels,Nvars,");
+  fprintf(fpout,"Var_mask,Offset\n");
+  return 0;
+ }
  fprintf(fpout,"Time,WOD_unique,depth(m),qc_flag");
  if ( jchoice != 0 ) 
-   fprintf(fpout,",%s,qc_flag\n",namevar[jchoice-1]);
+   fprintf(fpout,",%s,qc_flag",namevar[jchoice-1]);
  else
   {
    for ( k = 0; k < nvars; k++ ) {
     fprintf(fpout,",%s,qc_flag",namevar[k]);
    }
-    fprintf(fpout,"\n");
   } 
+ for ( k = 0; k < nseccol; k++ ) fprintf(fpout,",sec_%d",*(seccol+k));
+ fprintf(fpout,"\n");
 
 }
  
@@ -922,7 +5117,8 @@ printheader( int jchoice )
 
               FUNCTION PRINTSTATION
 
- PRINTSTATION PRINTS CAST TO THE SCREEN
+ PRINTSTATION WRITES THE ROWS OF THE CAST TO THE CSV FILE, WITH
+ THE OUTPUT KERNEL PICKED FOR THE RUN (SEE PICKKERNEL)
 
 ***************************************************************/
 
@@ -930,141 +5126,246 @@ printstation(int i, int jchoice)
 
 {
 
- int ii, ij, j, k, k0, offs,hastmp, yright,yall,zright;
- int lat,lon,itseas, ixa, inbp;
- int iwritten=0, k2,loopvars,j0;
- int xright[maxparm],xall[maxparm];
- float x[maxparm];
- int ichoice[maxchoice],ilevelwrite;
- int kblock= idim * jdim, iblock= kdim * kblock;
- float xlon, xlat, xhour, y, z, xa, spaced=1.+1.E-07;
-
- ichoice[0]=1;
- ichoice[1]=2;
- ichoice[2]=3;
- ichoice[3]=4;
- ichoice[4]=6;
- ichoice[5]=8;
- ichoice[6]=9;
- ichoice[7]=17;
+ int j, j0, hastmp=-1;
+ float xlon, xlat, xhour;
+ char *p= rowhead;
 
+ if ( subsetmode == 1 ) return copycast();
+ if ( invmode == 1 ) return printinv();
 
 /***************************************************************
 
- PRINT OUT HEADER
+ FORMAT THE HEADER COLUMNS, THE SAME FOR EVERY ROW OF THE CAST
 
 ****************************************************************/
 
+ if ( levels <= 0 ) return 0;
+
  xhour= (hour/ tenp[ *(hrightfig) ]);
  xlat= (latitude/ tenp[ *(hrightfig+1) ]);
  xlon= (longitude/ tenp[ *(hrightfig+2) ]);
 
- lat= ((xlat + 90.)/spaced)+1.;
+ p += sprintf(p,"%2s,%d,%.3f,%.3f,%4d,%2d,%2d,",
+              cc,icruise,xlat,xlon,year,month,day);
+ if ( xhour >= 0.0 && xhour <= 24.0 ) p += sprintf(p,"%.2f,",xhour);
+ else *(p++)= ',';
+ sprintf(p,"%d,",ostation);
 
- if ( xlon < 0. ) lon=((xlon+360.)/spaced)+1.;
- else lon=(xlon/spaced)+1.;
- itseas=((month-1)/3)+13;
+/***************************************************************
 
- if ( levels > 0 ) {
+ FIND WHERE EACH VARIABLE WRITTEN IS IN IP2 (A VARIABLE WHOSE
+ PROFILE IS REJECTED COUNTS AS ABSENT)
 
-  if ( jchoice > 0 ) {
-   hastmp=-1;
-   loopvars=0;
-   for ( j = 0; j < nparm; j++ ) {
-    if ( *(ip2+ j) == jchoice ) hastmp=j;
-   }
+****************************************************************/
 
+ if ( jchoice > 0 ) {
+  for ( j = 0; j < nparm; j++ )
+   if ( *(ip2+j) == jchoice && *(profok+j) ) hastmp=j;
+  if ( hastmp == -1 ) return 0;
+ }
+ else {
+  for ( j = 0; j < nvars; j++ ) {
+   *(varcol+j)= -1;
+   for ( j0 = 0; j0 < nparm; j0++ )
+    if ( *(ip2+j0) == j+1 && *(profok+j0) ) *(varcol+j)= j0;
   }
-  else {
+ }
 
-   hastmp=0;
-   loopvars=nvars-1;
+ if ( nseccol > 0 ) secfill();
 
-  }
-  if ( hastmp > -1 ) {
+ return (*printrows)(hastmp);
+
+}
 
-   ilevelwrite=0;
+/***************************************************************
 
-   for ( k0 = 0; k0 < levels; k0++ ) {
+              FUNCTION PRINTINV
 
-    k=k0;
-    if ( *xchoice == 'B' ) k= (levels - k0 - 1 );
+ PRINTINV WRITES THE INVENTORY ROW OF THE CAST: ITS HEADER
+ COLUMNS AS IN THE CONVERTED FILE, NUMBER OF LEVELS, OBSERVED (0)
+ OR STANDARD (1) LEVELS, NUMBER OF VARIABLES, A BIT MASK OF THE
+ VARIABLE CODES PRESENT (BIT CODE-1, CODES 1 TO 64) AND THE BYTE
+ OFFSET OF THE CAST IN THE WOD FILE
 
-    iwritten=1;
-    if ( jchoice > 0 ) {
-     iwritten=0;
-     offs=hastmp * levels;
-     if ( *(dsigfig+offs+k) > 0 ) iwritten=1;
-    }
+***************************************************************/
 
-    zright = *(zrightfig+k);
-    z = (*(depth+k)/ tenp[zright]);
-    if ( zright > 6 ) zright=6;
+printinv()
 
-    if ( *xchoice == 'B' ||
-         *xchoice == 'S' ) {
-     if ( ilevelwrite != 0 ) iwritten=0; 
-    }
-    else if ( *xchoice == 'I' ) {
-     if ( z < xinterv1 ||
-          z > xinterv2 ) iwritten=0;
-    }
- 
-    if ( iwritten == 1 ) {
-     ilevelwrite=1;
-
-     fprintf(fpout,"%2s,%d,%.3f,%.3f,%4d,%2d,%2d,",
-      cc,icruise,xlat,xlon,year,month,day);
-     if ( xhour >= 0.0 && xhour <= 24.0 ) 
-      fprintf(fpout,"%.2f,",xhour);
-     else
-      fprintf(fpout,",");
-     fprintf(fpout,"%d,",ostation);
- 
-     fprintf(fpout,"%.*f",*(zrightfig+k),z);
-     fprintf(fpout,",%d",*(zerr+k));
+{
 
-     for ( j = 0; j <= loopvars; j++ ) {
+ int j;
+ unsigned long mask=0;
+ float xlon, xlat, xhour;
 
-      if ( jchoice == 0 ) {
-       hastmp=-1;
-       for ( j0 = 0; j0 < nparm; j0++ ) {
-        if ( *(ip2+ j0) == j+1 ) hastmp=j0;
-       }
-      }
+ for ( j = 0; j < nparm; j++ )
+  if ( *(ip2+j) >= 1 && *(ip2+j) <= 64 )
+   mask |= 1UL << ( *(ip2+j) - 1 );
 
-      if ( hastmp > -1 ) {
+ xhour= (hour/ tenp[ *(hrightfig) ]);
+ xlat= (latitude/ tenp[ *(hrightfig+1) ]);
+ xlon= (longitude/ tenp[ *(hrightfig+2) ]);
 
-       offs= hastmp * levels;
-      
-       yright=0;
-       yall=0;
+ fprintf(fpout,"%2s,%d,%.3f,%.3f,%4d,%2d,%2d,",
+         cc,icruise,xlat,xlon,year,month,day);
+ if ( xhour >= 0.0 && xhour <= 24.0 ) fprintf(fpout,"%.2f,",xhour);
+ else fputc(',',fpout);
+ fprintf(fpout,"%d,%d,%d,%d,%lu,%ld\n",ostation,levels,isoor,nparm,
+         mask,castoffset);
 
-       yright = *(drightfig+offs+k);
-       yall = *(dtotfig+offs+k);
-       y = (*(dataval+offs+k)/ tenp[yright]);
-       if ( yright > 6 ) yright=6;
+ return 0;
 
-       fprintf(fpout,",%.*f",yright,y);
-       fprintf(fpout,",%d",*(derr+offs+k));
+}
 
-      }
+/***************************************************************
 
-      else 
-       fprintf(fpout,",,");
-     
-     }
+              FUNCTION COPYCAST
 
-     fprintf(fpout,"\n");
+ COPYCAST ADDS THE PRESENT CAST (JUST READ, FROM CASTOFFSET TO THE
+ PRESENT POSITION OF THE WOD FILE) TO THE BYTES WAITING TO BE
+ COPIED TO THE SUBSET FILE.  A CAST WHICH DOES NOT FOLLOW THOSE
+ WAITING HAS THEM COPIED FIRST (COPYFLUSH).  RETURNS ZERO, OR -1
+ IF THE SUBSET FILE CANNOT BE WRITTEN.
 
-    }
+***************************************************************/
 
-   }
+copycast()
 
-  }
+{
+
+ if ( castoffset != copyto && copyflush() != 0 ) return -1;
+ if ( copyfrom == copyto ) copyfrom= castoffset;
+ copyto= ftell(fp);
+
+/***************************************************************
+
+ A SUBSET BEING WRITTEN TO MEMORY (-s) IS COPIED CAST BY CAST
+
+****************************************************************/
+
+ return ( fileno(fpout) == -1 ) ? copyflush() : 0;
+
+}
+
+/***************************************************************
+
+              FUNCTION COPYFLUSH
+
+ COPYFLUSH COPIES THE BYTES OF THE WOD FILE WAITING (COPYFROM TO
+ COPYTO) TO THE SUBSET FILE.  THE COPY IS DONE BY THE KERNEL FILE
+ TO FILE (COPY_FILE_RANGE) WHEN IT CAN, ELSE THROUGH A BUFFER.
+ NEITHER MOVES THE WOD FILE.  RETURNS ZERO, OR -1 IF THE BYTES
+ COULD NOT ALL BE COPIED.
 
+***************************************************************/
+
+copyflush()
+
+{
+
+ char buf[65536];
+ int fdin= ( statmode == 1 ) ? statfd : fileno(fp);
+ int fdout= fileno(fpout);
+ loff_t from= copyfrom;
+ long left= copyto - copyfrom;
+ ssize_t n;
+
+ copyfrom= copyto;
+ if ( left <= 0 ) return 0;
+
+ if ( fdout != -1 && fflush(fpout) == 0 )
+  while ( left > 0 &&
+          (n = copy_file_range(fdin,&from,fdout,NULL,left,0)) > 0 )
+   left -= n;
+
+ while ( left > 0 && (n = pread(fdin,buf,( left < sizeof(buf) ) ?
+                                left : sizeof(buf),from)) > 0 ) {
+  if ( fwrite(buf,1,n,fpout) != n ) return -1;
+  from += n;
+  left -= n;
+ }
+
+ if ( left > 0 ) {
+  printf(" UNABLE TO COPY %ld BYTES TO THE SUBSET FILE\n",left);
+  return -1;
  }
 
+ return 0;
+
+}
+
+/***************************************************************
+
+              OUTPUT KERNELS
+
+ PRINTROWS(MODE,PROJ) IS THE BODY OF A FUNCTION WRITING THE ROWS
+ OF THE PRESENT CAST FOR DEPTH MODE MODE ('A', 'S', 'B' OR 'I')
+ AND EITHER ALL VARIABLES (PROJ ZERO, COLUMNS FROM VARCOL) OR THE
+ ONE AT POSITION HASTMP IN IP2 (PROJ ONE).  ONE FUNCTION IS MADE
+ FOR EACH PAIR, SO THE TESTS ON MODE AND PROJ ARE DECIDED WHEN
+ COMPILING, AND PICKKERNEL CHOOSES ONE ONCE PER RUN.
+
+***************************************************************/
+
+#define PRINTROWS(MODE,PROJ) \
+{ \
+ int j, k, k0, offs, yright; \
+ float y, z; \
+ for ( k0 = 0; k0 < nzread; k0++ ) { \
+  k= ( MODE == 'B' ) ? nzread - k0 - 1 : k0; \
+  if ( !levelout(k,( PROJ ) ? hastmp : -1) ) continue; \
+  z = (*(depth+k)/ tenp[*(zrightfig+k)]); \
+  if ( MODE == 'I' && ( z < xinterv1 || z > xinterv2 ) ) continue; \
+  fputs(rowhead,fpout); \
+  fprintf(fpout,"%.*f,%d",*(zrightfig+k),z,*(zerr+k)); \
+  for ( j = 0; j < ( ( PROJ ) ? 1 : nvars ); j++ ) { \
+   offs= ( PROJ ) ? hastmp : *(varcol+j); \
+   if ( offs > -1 && ( qcmode == 0 || qcvalue(offs,k) ) ) { \
+    offs= offs * levels + k; \
+    yright = *(drightfig+offs); \
+    y = (*(dataval+offs)/ tenp[yright]); \
+    if ( yright > 6 ) yright=6; \
+    fprintf(fpout,",%.*f,%d",yright,y,*(derr+offs)); \
+   } \
+   else fputs(",,",fpout); \
+  } \
+  if ( nseccol > 0 ) fputs(secrow,fpout); \
+  putc('\n',fpout); \
+  if ( MODE == 'S' || MODE == 'B' ) break; \
+ } \
+ return 0; \
+}
+
+printAall(int hastmp) PRINTROWS('A',0)
+printAone(int hastmp) PRINTROWS('A',1)
+printSall(int hastmp) PRINTROWS('S',0)
+printSone(int hastmp) PRINTROWS('S',1)
+printBall(int hastmp) PRINTROWS('B',0)
+printBone(int hastmp) PRINTROWS('B',1)
+printIall(int hastmp) PRINTROWS('I',0)
+printIone(int hastmp) PRINTROWS('I',1)
+
+/***************************************************************
+
+              FUNCTION PICKKERNEL
+
+ PICKKERNEL SETS PRINTROWS TO THE OUTPUT KERNEL FOR DEPTH MODE
+ MODE AND FOR ALL VARIABLES (JCHOICE ZERO) OR ONE
+
+***************************************************************/
+
+pickkernel(int mode, int jchoice)
+
+{
+
+ int one= ( jchoice > 0 );
+
+ if ( mode == 'S' ) printrows= ( one ) ? printSone : printSall;
+ else if ( mode == 'B' ) printrows= ( one ) ? printBone : printBall;
+ else if ( mode == 'I' ) printrows= ( one ) ? printIone : printIall;
+ else printrows= ( one ) ? printAone : printAall;
+
+ return 0;
+
 }
 
 /************************************************************
@@ -1076,9 +5377,8 @@ printstation(int i, int jchoice)
 spacer(
  
  int intime      /* SET TO ONE TO INITIALIZE ALL DYNAMIC ARRAYS,
-                    SET TO TWO TO REDIMENSION TAXA ARRAYS,
-                    SET TO THREE TO REDIMENSION DEPTH, 
-                    SET TO FOUR TO REDIMENSION MEASURED VARIABLE ARRAYS
+                    (ALL ARRAYS ARE REDIMENSIONED BY
+                    SPACERFIT AND TAXFIT)
                  */
 
       )
@@ -1093,178 +5393,130 @@ spacer(
 
 ****************************************************************/
 
-  ntsets=1;
-  ntsetsmax=1;
-  if ( (ntcode =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntloc =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nttotfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntsigfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntrightfig =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntval =calloc( ntsets * maxtax, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nterr =calloc( ntsets * maxtax, sizeof(int)) )
-        == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntoerr =calloc( ntsets * maxtax, sizeof(int)) )
-        == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
- 
+  ntsetsmax= 0;
+  ntentmax= 0;
+  taxfit(1,maxtax);
+
 /***************************************************************
 
  ALLOCATE SPACE FOR DEPTH AND MEASURED VARIABLES
 
 ****************************************************************/
 
-  zsize= kdimax;
-  zsizemax= kdimax;
-  if ( (ztotfig =calloc(zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zsigfig =calloc(zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zrightfig =calloc(zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (depth =calloc( zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zerr =calloc( zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zoerr =calloc( zsize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
- 
-  isize=kdimax;
-  isizemax= kdimax;
-  if ( (dtotfig =calloc(isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
-  if ( (dsigfig =calloc(isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
-  if ( (drightfig =calloc(isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
-  if ( (dataval =calloc( isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
-  if ( (derr =calloc( isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
-  if ( (doerr =calloc( isize, sizeof(int)) )
-       == NULL )
-    printf( " NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA\n");
- 
+  zsizemax= 0;
+  isizemax= 0;
+  spacerfit(kdimax,kdimax);
+
  }
 
-/***************************************************************
+}
+
+/**********************************************************
 
- REALLOCATE SPACE FOR TAXA DATA
+                 FUNCTION SPACERFIT
 
-****************************************************************/
+ SPACERFIT MAKES SURE THERE IS ROOM FOR NZ DEPTHS AND NI
+ MEASURED VALUES.  ALL TWELVE DEPTH AND MEASURED VARIABLE ARRAYS
+ ARE CUT FROM ONE BLOCK, WHICH IS REPLACED BY ONE AT LEAST TWICE
+ THE SIZE WHEN IT IS OUTGROWN (CONTENTS ARE NOT KEPT, SO THIS IS
+ ONLY CALLED BEFORE A CAST'S LEVELS ARE READ).  IF THE SPACE
+ CANNOT BE HAD THE PROGRAM STOPS.
+
+***********************************************************/
+
+spacerfit(int nz, int ni)
+
+{
+
+ if ( nz <= zsizemax && ni <= isizemax ) return 0;
 
- else if ( intime == 2 ) {
-
-   ntsetsmax = ntsets;
-   if ( (ntcode =realloc( ntcode, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntloc =realloc( ntloc, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nttotfig =realloc( nttotfig, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntsigfig =realloc( ntsigfig, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntrightfig =realloc( ntrightfig, ntsets * maxtax * sizeof(int)))
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntval =realloc( ntval, ntsets * maxtax * sizeof(int)) )
-        == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (nterr =realloc( nterr, ntsets * maxtax * sizeof(int)) )
-         == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
-  if ( (ntoerr =realloc( ntoerr, ntsets * maxtax * sizeof(int)) )
-         == NULL )
-     printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ntsets);
+ if ( nz < zsizemax ) nz= zsizemax;
+ else if ( nz > zsizemax && nz < 2 * zsizemax ) nz= 2 * zsizemax;
+ if ( ni < isizemax ) ni= isizemax;
+ else if ( ni > isizemax && ni < 2 * isizemax ) ni= 2 * isizemax;
 
+ free(zblock);
+ if ( (zblock = calloc(6L * nz + 6L * ni, sizeof(int))) == NULL ) {
+  printf( " NOT ENOUGH SPACE IN MEMORY FOR %d DEPTHS AND %d VALUES\n",
+          nz, ni);
+  exit(1);
  }
 
-/***********************************************************
+ zsizemax= nz;
+ isizemax= ni;
 
- REALLOCATE SPACE FOR DEPTH
+ ztotfig= zblock;
+ zsigfig= ztotfig + nz;
+ zrightfig= zsigfig + nz;
+ depth= zrightfig + nz;
+ zerr= depth + nz;
+ zoerr= zerr + nz;
+ dtotfig= zoerr + nz;
+ dsigfig= dtotfig + ni;
+ drightfig= dsigfig + ni;
+ dataval= drightfig + ni;
+ derr= dataval + ni;
+ doerr= derr + ni;
 
-************************************************************/
+ return 0;
 
- else if ( intime == 3 ) {
-
-  if ( (ztotfig =realloc( ztotfig, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #1 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zsigfig =realloc( zsigfig, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #2 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zrightfig =realloc( zrightfig, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #3 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (depth =realloc( depth, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #4 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zerr =realloc( zerr, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #5 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
-  if ( (zoerr =realloc( zoerr, zsize * sizeof(int)) )
-       == NULL )
-    printf( " #6 NOT ENOUGH SPACE IN MEMORY FOR DEPTH DATA\n");
+}
 
- }
+/**********************************************************
 
-/************************************************************
+                 FUNCTION TAXFIT
 
- REALLOCATE SPACE FOR MEASURED VARIABLES
+ TAXFIT MAKES SURE THERE IS ROOM FOR NS TAXA SETS HOLDING NE
+ ENTRIES IN ALL.  THE ENTRIES OF ALL SETS ARE PACKED END TO END
+ (SET J HOLDS ENTRIES NTSTART(J) TO NTSTART(J+1)-1), AND ALL TAXA
+ ARRAYS ARE CUT FROM ONE BLOCK, WHICH IS REPLACED BY ONE AT LEAST
+ TWICE THE SIZE, KEEPING ITS CONTENTS, WHEN IT IS OUTGROWN.  IF
+ THE SPACE CANNOT BE HAD THE PROGRAM STOPS.
 
-*************************************************************/
+***********************************************************/
 
- else if ( intime == 4 ) {
-
-  if ( (dtotfig =realloc( dtotfig, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
-  if ( (dsigfig =realloc( dsigfig, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
-  if ( (drightfig =realloc( drightfig, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
-  if ( (dataval =realloc( dataval, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
-  if ( (derr =realloc( derr, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
-  if ( (doerr =realloc( doerr, isize * sizeof(int)) )
-       == NULL )
-    printf(" NOT ENOUGH SPACE IN MEMORY FOR MEASURED DATA");
- 
+taxfit(int ns, int ne)
+
+{
+
+ static int **entry[] = { &ntcode, &ntval, &nterr, &ntoerr, &nttotfig,
+                          &ntsigfig, &ntrightfig };
+ int *old= taxblock;
+ int k;
+
+ if ( ns <= ntsetsmax && ne <= ntentmax ) return 0;
+
+ if ( ns < ntsetsmax ) ns= ntsetsmax;
+ else if ( ns > ntsetsmax && ns < 2 * ntsetsmax ) ns= 2 * ntsetsmax;
+ if ( ne < ntentmax ) ne= ntentmax;
+ else if ( ne > ntentmax && ne < 2 * ntentmax ) ne= 2 * ntentmax;
+
+ if ( (taxblock = calloc(2L * ns + 1 + 7L * ne, sizeof(int))) == NULL ) {
+  printf( " NOT ENOUGH SPACE IN MEMORY FOR %d TAXA SETS\n", ns);
+  exit(1);
  }
 
+ if ( old != NULL ) {
+  memcpy(taxblock,ntloc,ntsetsmax * sizeof(int));
+  memcpy(taxblock+ns,ntstart,(ntsetsmax+1) * sizeof(int));
+ }
+ ntloc= taxblock;
+ ntstart= ntloc + ns;
+
+ for ( k = 0; k < 7; k++ ) {
+  if ( old != NULL )
+   memcpy(ntstart+ns+1+k*ne,*(*(entry+k)),ntentmax * sizeof(int));
+  *(*(entry+k))= ntstart + ns + 1 + k * ne;
+ }
+
+ free(old);
+ ntsetsmax= ns;
+ ntentmax= ne;
+
+ return 0;
+
 }
+
 /**********************************************************
 
                  FUNCTION EXTRACTI
@@ -1316,7 +5568,7 @@ extracti(
 
 {
 
- int sign,j,i;
+ int sign,j,i=0;
 
 /********************************************************
 
@@ -1527,11 +5779,121 @@ nocrfgetc()
  while ( !feof(fp) && isprint ( (i=fgetc(fp)) ) == 0 );
 
  if ( feof(fp) ) i = -1;
+ else castbytes++;
 
  return i;
 
 } 
 
+/***********************************************
+
+          FUNCTION SKIPBYTES
+
+ SKIPBYTES READS PAST THE NEXT N BYTES OF THE PRESENT CAST
+ WITHOUT DECODING THEM
+
+ RETURNS 0, OR -1 FOR END OF FILE
+
+************************************************/
+
+skipbytes(int n)
+
+{
+
+ int end= castbytes + n;
+
+ while ( castbytes < end && nocrfgetc() != -1 );
+ return ( feof(fp) ) ? -1 : 0;
+
+}
+
+/***********************************************
+
+          FUNCTION SKIPVALUE
+
+ SKIPVALUE READS PAST A DEPTH (ZFLAGS ONE) OR DATA VALUE (ZFLAGS
+ ZERO) AND ITS FLAGS WITHOUT DECODING IT, USING ITS TOTAL FIGURES.
+ A DEPTH ALWAYS HAS ITS TWO FLAGS, A DATA VALUE ONLY IF PRESENT.
+
+ RETURNS 0, OR -1 FOR END OF FILE
+
+************************************************/
+
+skipvalue(int zflags)
+
+{
+
+ int tot=0;
+
+ if ( nocrfgetc() != '-' ) {
+  tot= nocrfgetc() - '0';
+  nocrfgetc();
+ }
+
+ if ( zflags == 1 || tot > 0 ) tot += 2;
+ return skipbytes(tot);
+
+}
+
+/***********************************************
+
+          FUNCTION SKIPCAST
+
+ SKIPCAST READS PAST THE REST OF THE PRESENT CAST WITHOUT
+ DECODING IT, USING THE NUMBER OF BYTES IN THE CAST (NBYTET)
+
+ RETURNS 1 (CAST SKIPPED) OR -1 FOR END OF FILE
+
+************************************************/
+
+skipcast(int nbytet)
+
+{
+
+ return ( skiprest(nbytet - castbytes) == -1 ) ? -1 : 1;
+
+}
+
+/***********************************************
+
+          FUNCTION SKIPREST
+
+ SKIPREST READS PAST THE NEXT N BYTES OF THE PRESENT CAST AND
+ THE REST OF THE LINE IT ENDS ON, A LINE AT A TIME WITHOUT
+ DECODING THEM
+
+ RETURNS 0, 1 IF ANYTHING BUT BLANKS FOLLOWS THE CAST ON ITS
+ LAST LINE, OR -1 FOR END OF FILE BEFORE THE END OF THE CAST
+
+************************************************/
+
+skiprest(long n)
+
+{
+
+ char line[4096];
+ unsigned char *p;
+ int tail=0;
+
+ while ( fgets(line,sizeof(line),fp) != NULL ) {
+
+  for ( p = (unsigned char *) line; *p != '\0'; p++ ) {
+   if ( !isprint(*p) ) continue;
+   if ( n > 0 ) {
+    n--;
+    castbytes++;
+   }
+   else if ( *p != ' ' ) tail= 1;
+  }
+
+  if ( n <= 0 && *(p-1) == '\n' ) return tail;
+
+ }
+
+ return ( n <= 0 ) ? tail : -1;
+
+}
+
 nocrfgetcwoa()
 
 {